@@ -3,6 +3,7 @@
 #include <iostream>
 #include <vector>
 #include <stdint.h>
+#include <type_traits>
 
 // Playing cards, with an unusual order.
 //
@@ -40,7 +41,6 @@ namespace spider {
 
     uint8_t order;
     Card();
-    Card(const Card &card);
     Card(uint8_t _order);
 
 
@@ -71,7 +71,6 @@ namespace spider {
 
     bool operator>=(const Card &to) const;
     bool operator>(const Card &to) const;
-    void operator=(const Card &card);
 
     // Cards representing useful encodings.
     static const Card SHIFT_LOCK_DOWN;
@@ -83,6 +82,9 @@ namespace spider {
     static const Card BACKSLASH;
   };
 
+  // a card is just its order byte, so arrays of cards copy as memory.
+  static_assert(std::is_trivially_copyable<Card>::value, "Card must be trivially copyable");
+
   std::ostream& operator<<(std::ostream &out, const Card &card);
   std::istream& operator>>(std::istream &in, Card &card);  
   std::ostream& operator<<(std::ostream &out, const std::vector<Card> &cards);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <stdint.h>
+#include <type_traits>
+
+#include "card.h"
+
+namespace spider {
+
+  //
+  // Inline card storage, so decks copy with a memcpy instead of a heap
+  // allocation: up to CAPACITY cards (a full deck with jokers), sized
+  // at run time.  The deck size is fixed at compile time only inside
+  // Deck::cutBackFrontShuffle, for the 10 and 40 card decks.
+  //
+  // It mimics the parts of std::vector<Card> decks have always used.
+  //
+  struct CardArray {
+    static const unsigned CAPACITY = 54;
+    uint8_t count;
+    Card items[CAPACITY];
+
+    CardArray() : count(0) {}
+    // n blank (zero) cards
+    CardArray(size_t n) : count(n) {
+      assert(n <= CAPACITY);
+      for (size_t i=0; i<n; ++i) items[i] = Card(0);
+    }
+    CardArray(const std::vector<Card> &cards) : count(0) {
+      assign(cards.begin(),cards.end());
+    }
+
+    size_t size() const { return count; }
+    // new cards are blank (zero)
+    void resize(size_t n) {
+      assert(n <= CAPACITY);
+      for (size_t i=count; i<n; ++i) items[i] = Card(0);
+      count = n;
+    }
+
+    template <typename Iterator>
+    void assign(Iterator first, Iterator last) {
+      count = 0;
+      while (first != last) {
+	assert(count < CAPACITY);
+	items[count++]=*first++;
+      }
+    }
+
+    Card* data() { return items; }
+    const Card* data() const { return items; }
+    Card* begin() { return items; }
+    Card* end() { return items+count; }
+    const Card* begin() const { return items; }
+    const Card* end() const { return items+count; }
+    Card& operator[](size_t i) { return items[i]; }
+    const Card& operator[](size_t i) const { return items[i]; }
+
+    void swap(CardArray &with) {
+      CardArray tmp(*this);
+      *this = with;
+      with = tmp;
+    }
+
+    void swap(std::vector<Card> &with) {
+      std::vector<Card> tmp(begin(),end());
+      assign(with.begin(),with.end());
+      with.swap(tmp);
+    }
+
+    operator std::vector<Card>() const {
+      return std::vector<Card>(begin(),end());
+    }
+  };
+
+  static_assert(std::is_trivially_copyable<CardArray>::value, "CardArray must copy as memory");
+
+  template <typename A, typename B>
+  bool equalCards(const A &a, const B &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i=0; i<a.size(); ++i) {
+      if (a[i] != b[i]) return false;
+    }
+    return true;
+  }
+
+  inline bool operator==(const CardArray &a, const CardArray &b) { return equalCards(a,b); }
+  inline bool operator!=(const CardArray &a, const CardArray &b) { return !equalCards(a,b); }
+  inline bool operator==(const CardArray &a, const std::vector<Card> &b) { return equalCards(a,b); }
+  inline bool operator==(const std::vector<Card> &a, const CardArray &b) { return equalCards(a,b); }
+  inline bool operator!=(const CardArray &a, const std::vector<Card> &b) { return !equalCards(a,b); }
+  inline bool operator!=(const std::vector<Card> &a, const CardArray &b) { return !equalCards(a,b); }
+
+  inline std::ostream& operator<<(std::ostream &out, const CardArray &cards) {
+    out << "[";
+    for (size_t i=0; i<cards.size(); ++i) {
+      if (i > 0) out << ",";
+      out << cards[i];
+    }
+    out << "]";
+    return out;
+  }
+
+  inline std::istream& operator>>(std::istream &in, CardArray &cards) {
+    std::vector<Card> tmp;
+    if (in >> tmp) {
+      if (tmp.size() <= CardArray::CAPACITY) {
+	cards.assign(tmp.begin(),tmp.end());
+      } else {
+	in.setstate(std::ios::failbit);
+      }
+    }
+    return in;
+  }
+}
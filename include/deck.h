@@ -2,11 +2,14 @@
 #include <iostream>
 #include <vector>
 #include <set>
+#include <algorithm>
+#include <cassert>
 
 #include "retain.hpp"
 
 #include "rng.h"
 #include "card.h"
+#include "card_array.h"
 
 namespace spider {
   struct DeckConfig {
@@ -27,10 +30,50 @@ namespace spider {
   };
 
   struct Deck {
-    std::vector<Card> cards;
+    // inline storage for any supported deck size, so copying a deck
+    // never allocates.
+    typedef CardArray Cards;
 
-    static int padLoc(const std::vector<Card> &cards, int zth, int offset, int modulus);
-    static const DeckConfig& config();
+    // largest supported deck: 40 cipher cards, J,Q,K and two jokers.
+    static const unsigned MAX_SIZE = Cards::CAPACITY;
+
+    Cards cards;
+
+    // Optional inverse of cards: locs[card.order] is the location of
+    // card, making find() a single load.  It is kept up to date by
+    // reset, shuffle, mix, unmix and pseudoShuffle; call index() again
+    // after writing to cards directly.
+    bool indexed;
+    uint8_t locs[MAX_SIZE];
+
+    // start (or refresh) the inverse index
+    void index();
+
+    // stop keeping the inverse index
+    void unindex();
+
+    //
+    // The static helpers below work on any card container: Cards or
+    // std::vector<Card>.
+    //
+    template <typename Container>
+    static int padLoc(const Container &cards, int zth, int offset, int modulus);
+    // same as padLoc(cards,...), finding the mark through the index if kept.
+    int padLoc(int zth, int offset) const;
+    // the recalled retain<const DeckConfig>, or DeckConfig::DEFAULT
+    static const DeckConfig& config() {
+      auto recalled = retain<const DeckConfig>::begin();
+      return (recalled != retain<const DeckConfig>::end()) ? *recalled : DeckConfig::DEFAULT;
+    }
+
+    // Optional config of this deck, used instead of the recalled one;
+    // 0 (the default) follows config().  Copies keep the binding, so
+    // decks with different configs can run side by side in one thread
+    // without a thread local lookup per pad.
+    const DeckConfig *bound;
+
+    void bind(const DeckConfig *cfg) { bound = cfg; }
+    const DeckConfig& boundConfig() const { return bound != 0 ? *bound : config(); }
     //
     // Modulus is 10 or 40.
     //
@@ -47,23 +90,31 @@ namespace spider {
     // replace with ordered deck (see card for order, it is not normal)
     void reset();
     void shuffle(RNG &rng);
+    // same draws as shuffle(RNG&), inlined for a known generator type
+    template <typename Generator>
+    void shuffle(Generator &rng);
     
     Deck(size_t size);
   
     int find(const Card &card) const;
-    static int find(const std::vector<Card> &cards, const Card &card);
+    template <typename Container>
+    static int find(const Container &cards, const Card &card);
 
     // move forward delta card skipping J,Q,K
-    static unsigned forward(const std::vector<Card> &cards, unsigned index, unsigned delta);
+    template <typename Container>
+    static unsigned forward(const Container &cards, unsigned index, unsigned delta);
 
     // move back delta card skipping J,Q,K
-    static unsigned back(const std::vector<Card> &cards, unsigned index, unsigned delta);
+    template <typename Container>
+    static unsigned back(const Container &cards, unsigned index, unsigned delta);
     
     // find card after given card, skipping J,Q,K and jokers.
-    static const Card& after(const std::vector<Card> &cards, const Card &card);
+    template <typename Container>
+    static const Card& after(const Container &cards, const Card &card);
 
     // find card after given card, skipping J,Q,K and jokers.
-    static const Card& before(const std::vector<Card> &cards, const Card &card);
+    template <typename Container>
+    static const Card& before(const Container &cards, const Card &card);
 
     Card addMod(const Card &a, const Card &b) const;
 
@@ -93,11 +144,25 @@ namespace spider {
     // not reveal any information the user does not already know.
     void unmix(const Card &plain);
 
-    static void cut(const std::vector<Card> &in, int cutLoc, std::vector<Card> &out);
-    static void backFrontShuffle(const std::vector<Card> &in, std::vector<Card> &out);
-    static void backFrontUnshuffle(const std::vector<Card> &in, std::vector<Card> &out);    
+    template <typename In, typename Out>
+    static void cut(const In &in, int cutLoc, Out &out);
+    template <typename In, typename Out>
+    static void backFrontShuffle(const In &in, Out &out);
+    template <typename In, typename Out>
+    static void backFrontUnshuffle(const In &in, Out &out);
+
+    // precomputed source locations of the back-front shuffle for an
+    // n card deck: backFrontShuffle(in,out) is out[i]=in[source[i]].
+    static const uint8_t* backFrontSource(unsigned n);
+
+    // fused in-place cut at cutLoc then back-front shuffle; the same
+    // permutation as cut() followed by backFrontShuffle(), but in a
+    // single gather pass with no heap allocation.  The 10 and 40 card
+    // decks run specializations with the size fixed at compile time.
+    // If locs is not null, it is updated as the inverse of the result.
+    static void cutBackFrontShuffle(Card *cards, unsigned n, unsigned cutLoc, uint8_t *locs=0);
+
     // apply the core shuffle
-    
     void pseudoShuffle(const Card &cut);
 
     bool operator<(const Deck &deck) const;
@@ -105,8 +170,130 @@ namespace spider {
     bool operator!=(const Deck &deck) const;    
   };
 
+  static_assert(std::is_trivially_copyable<Deck>::value, "Deck copies must not allocate");
+
   std::ostream& operator<<(std::ostream &out, const Deck &deck);
   std::ostream& operator<<(std::ostream &out, const std::set<Deck> &decks);
   int equivalent(const Deck &a, const Deck &b);
 
+  template <typename Container>
+  int Deck::padLoc(const Container &cards, int zth, int offset, int modulus) {
+    int zthLoc = forward(cards,0,zth);
+    if (offset >= 0) {
+      Card markCard=spider::addMod(cards[zthLoc],Card(offset),modulus);
+      int markLoc = find(cards,markCard);
+      int padLoc = forward(cards,markLoc,1);
+      return padLoc;
+    } else {
+      return zthLoc;
+    }
+  }
+
+  template <typename Container>
+  unsigned Deck::forward(const Container &cards, unsigned loc, unsigned delta) {
+    unsigned n = cards.size();
+    for (;;) {
+      while (cards[loc].order >= 40) {
+	++loc;
+	if (loc >= n) { loc = 0; }
+      }
+      if (delta == 0) return loc;
+      --delta;
+      ++loc;
+      if (loc >= n) { loc = 0; }      
+    }
+  }
+
+  template <typename Container>
+  unsigned Deck::back(const Container &cards, unsigned loc, unsigned delta) {
+    unsigned n = cards.size();
+    for (;;) {
+      while (cards[loc].order >= 40) {
+	if (loc == 0) { loc = n; }
+	--loc;
+      }
+      if (delta == 0) return loc;
+      --delta;
+      if (loc == 0) { loc = n; }
+      --loc;
+    }
+  }
+
+  template <typename Container>
+  int Deck::find(const Container &cards, const Card &card) {
+    auto loc = std::find(std::begin(cards), std::end(cards), card);
+    return (loc != std::end(cards)) ? loc-std::begin(cards) : -1;
+  }
+
+  template <typename Container>
+  const Card& Deck::after(const Container &cards, const Card &card) {
+    int loc = find(cards,card);
+    assert(loc >= 0);
+    return cards[forward(cards,loc,1)];
+  }
+
+  template <typename Container>
+  const Card& Deck::before(const Container &cards,const Card &card) {
+    int loc = find(cards,card);
+    assert(loc >= 0);
+    int beforeLoc = back(cards,loc,1);
+    return cards[beforeLoc];
+  }
+
+  template <typename In, typename Out>
+  void Deck::cut(const In &in, int cutLoc, Out &out) {
+    out.resize(in.size());
+    // copy bottom of deck (starting from cutLoc) to top of deck
+    std::copy(std::begin(in)+(cutLoc),std::end(in),std::begin(out));
+    // copy top of deck (up to but excluding cut card) to bottom of deck
+    std::copy(std::begin(in), std::begin(in)+(cutLoc),
+	      std::end(out)-(cutLoc));
+
+  }
+  
+  template <typename In, typename Out>
+  void Deck::backFrontShuffle(const In &in, Out &out) {
+    out.resize(in.size());
+    size_t back = in.size()/2;
+    size_t front = back-1;
+    for (size_t i=0; i<in.size(); ++i) {
+      if (i % 2 == 0) {
+	out[back]=in[i];
+	++back;
+      } else {
+	out[front]=in[i];
+	--front;
+      }
+    }
+  }
+  
+  template <typename In, typename Out>
+  void Deck::backFrontUnshuffle(const In &in, Out &out) {
+    out.resize(in.size());
+    int back = in.size();
+    int front = -1;
+    for (int i=in.size()-1; i >= 0; --i) {
+      if (i % 2 == 0) {
+	--back;
+	out[i]=in[back];
+
+      } else {
+	++front;
+	out[i]=in[front];
+      }
+    }
+  }
+
+  template <typename Generator>
+  void Deck::shuffle(Generator &rng) {
+    int n=cards.size();
+    for (int i=0; i<n; ++i) {
+      int j=rng.next(i,n-1);
+      Card tmp=cards[i];
+      cards[i]=cards[j];
+      cards[j]=tmp;
+    }
+    if (indexed) index();
+  }
+
 }
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "card.h"
+#include "deck.h"
+
+namespace spider {
+
+  //
+  // LANES independent decks of the same size, advanced together.
+  //
+  // The cards are kept structure-of-arrays: cards[loc] holds the card
+  // at location loc of every deck, one byte per lane, so each step of
+  // the pad lookups and the pseudo-shuffle is one vector operation over
+  // all the decks (AVX2 when the cpu has it).  Lanes are indexed
+  // 0..LANES-1 and are completely independent of each other.
+  //
+  // Pads and mixes honor the bound DeckConfig, or else the active one
+  // (Deck::config()) at the time of the call, exactly like
+  // Deck::cipherPad(), cutPad() and mix().
+  //
+  struct DeckBatch {
+    static const int LANES = 32;
+    typedef uint8_t Lanes __attribute__((vector_size(LANES)));
+
+    int n;
+    Lanes cards[Deck::MAX_SIZE];
+
+    // optional config of every lane, as Deck::bound, but a copy of
+    // the one given to bind() so a batch never outlives its config
+    bool bound;
+    DeckConfig config;
+
+    void bind(const DeckConfig *cfg) { bound = (cfg != 0); if (bound) config = *cfg; }
+    const DeckConfig& boundConfig() const { return bound ? config : Deck::config(); }
+
+    // every lane an ordered deck of n cards
+    DeckBatch(int n);
+
+    int modulus() const;
+
+    void set(int lane, const Deck &deck);
+    Deck get(int lane) const;
+
+    // per lane Deck::cipherPad()
+    void cipherPads(uint8_t pads[LANES]) const;
+
+    // per lane Deck::cutPad()
+    void cutPads(uint8_t pads[LANES]) const;
+
+    // per lane Deck::mix(plains[lane])
+    void mix(const uint8_t plains[LANES]);
+
+    // mix, then the per lane pads of the mixed decks: the usual step
+    // of an encryption or of a statistics trial.
+    void step(const uint8_t plains[LANES], uint8_t cipherPads[LANES], uint8_t cutPads[LANES]);
+  };
+}
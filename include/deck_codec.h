@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "card.h"
+#include "deck.h"
+
+namespace spider {
+
+  //
+  // Fixed width keys for deck states, and back.
+  //
+  // A key is the deck rotated to start at its first cipher card (the
+  // rotation equivalent() ignores; none for n <= 40), so equivalent
+  // decks have equal keys, in one of two formats:
+  //
+  //   RANK   the Lehmer code rank of the permutation, little endian in
+  //          the fewest bytes that hold n!-1: 3 bytes for n=10, 20 for
+  //          n=40, 30 for n=54.
+  //   PACKED 6 bits per card: 8 bytes for n=10, 30 for n=40, 41 for
+  //          n=54.  Cheaper to make than a rank.
+  //
+  // Keys compare equal exactly when the decks are equivalent(), and are
+  // plain bytes for hashing, sorting and writing to files.  A codec
+  // that does not rotate keys the deck as it is: equal keys are ==.
+  //
+  struct DeckCodec {
+    enum Format { RANK, PACKED };
+
+    // longest key of any deck size and format
+    static const size_t MAX_BYTES = 41;
+
+    int n;
+    Format format;
+    bool rotate;
+
+    DeckCodec(int n, Format format=RANK, bool rotate=true);
+
+    // bytes per key
+    size_t bytes() const { return m_bytes; }
+
+    // write the key of deck, returning its rotation: the location of
+    // its first cipher card
+    int encode(const Deck &deck, uint8_t *key) const;
+
+    // the deck of key, rotated back by rotation
+    Deck decode(const uint8_t *key, int rotation=0) const;
+
+    // the location of the first cipher card (Deck::forward(cards,0,0))
+    static int rotation(const Deck &deck);
+
+  private:
+    size_t m_bytes;
+    // 32 bit limbs the rank needs
+    int m_limbs;
+  };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "card.h"
+#include "deck.h"
+
+namespace spider {
+
+  //
+  // The pads and mix of one DeckConfig for one deck size, looked up
+  // once instead of on every step.
+  //
+  // Deck::cipherPad() and cutPad() recall the DeckConfig and walk
+  // padLoc() with the zth and offset known only at run time.  The pad
+  // functions here are compiled for a fixed deck size, zth and offset
+  // (the 10, 40, 52 and 54 card decks with the zths and offsets the
+  // sweeps explore), so the locations are constants and the mark is a
+  // single lookup.  Any other size or config uses the generic padLoc().
+  //
+  // A kernel always gives the same pads as Deck under the same config;
+  // hot loops (stats trials, Messenger) build one and call it instead.
+  //
+  struct DeckKernel {
+    typedef Card (*Pad)(const Deck &deck, int zth, int offset);
+
+    unsigned n;
+    DeckConfig cfg;
+    Pad cipher;
+    Pad cut;
+
+    DeckKernel(unsigned n, const DeckConfig &cfg);
+
+    // are both pads compiled for this config?
+    bool specialized() const;
+
+    Card cipherPad(const Deck &deck) const { return cipher(deck,cfg.cipherZth,cfg.cipherOffset); }
+    Card cutPad(const Deck &deck) const { return cut(deck,cfg.cutZth,cfg.cutOffset); }
+
+    // Deck::mix(plain) under cfg
+    void mix(Deck &deck, const Card &plain) const {
+      deck.pseudoShuffle(spider::addMod(cutPad(deck),plain,n == 10 ? 10 : 40));
+    }
+
+    // the pad of an n card deck, compiled if available
+    static Pad pad(unsigned n, int zth, int offset);
+
+    // Deck::padLoc() for any n, zth and offset
+    static Card generic(const Deck &deck, int zth, int offset);
+  };
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+#include "rng.h"
+#include "deck.h"
+
+namespace spider {
+
+  // running mean, sd, min and max of weighted samples
+  struct Stats {
+    double total;
+    double sum;
+    double sum2;
+    double min;
+    double max;
+    void reset() {
+      total = 0;
+      sum  = 0;
+      sum2 = 0;
+      min = 0;
+      max = 0;
+    }
+
+    Stats() {
+      reset();
+    }
+  
+    void add(double x, double w=1.0) {
+      if (total == 0 || x < min) {
+        min = x;
+      }
+      if (total == 0 || max < x) {
+        max = x;
+      }
+      total += w;
+      sum += w*x;
+      sum2 += w*x*x;
+    }
+
+    double mean() const  {
+      return sum / total;
+    }
+    double sd() const {
+      return sqrt(sum2/total-pow(sum/total,2));
+    }
+
+    void print(std::ostream &out) const {
+      out << "total=" << total << " mean=" << mean() << " sd=" << sd() << " min=" << min << " max=" << max;
+
+    }
+
+    void println(std::ostream &out) const {
+      print(out);
+      out << std::endl;
+    }
+  };
+
+  // z statistics of one z-trial
+  struct ZLuck {
+    double cipher;
+    double cipher2;
+    double cut;
+    double cut2;
+    double xy;
+  };
+
+  //
+  // Luck of the cipher and cut pads of a DeckConfig: zTrials
+  // independent z-trials, each a shuffled n card deck mixed by tTrials
+  // random and message cards, with the z of the pad histograms of each
+  // z-trial summarized over the z-trials.
+  //
+  struct DeckStats {
+    int n;
+    RNG &rng;
+    std::ostream &out;
+
+    int zTrials;
+    int tTrials;
+    int messageLen;
+
+    int id;
+    DeckConfig cfg;
+  
+    Stats zCipherStats;
+    Stats zCipher2Stats;      
+    Stats zCutStats;
+    Stats zCut2Stats;
+    Stats zXyStats;
+
+    bool progress;
+
+    // advance DeckBatch::LANES z-trials together
+    bool batch;
+
+    // worker threads running z-trials.  rng only seeds the z-trial
+    // streams and the lucks are added in z order, so the rows do not
+    // depend on the number of threads.
+    int threads;
+
+    // Sequential early stopping: with sprtAlpha > 0, stop at the first
+    // z-trial where Wald's SPRT rejects uniformity for any of the five
+    // z stats, testing mean z = 0 against mean z = sprtDelta (z is about
+    // N(0,1) for uniform pads and grows with bias).  As the zs are only
+    // approximately normal, the false rejection rate of a uniform config
+    // is approximately at most sprtAlpha (about sprtAlpha/2 on rng pads,
+    // see Stats.SprtUniform); configs that are not rejected run all
+    // zTrials.  Early stopping only saves whole chunks of z-trials, one
+    // per thread (DeckBatch::LANES z-trials each with batch).
+    double sprtAlpha;
+    double sprtDelta;
+
+    // z-trials run for the last row
+    int zUsed;
+
+    DeckStats(int _n = 40, RNG &_rng = RNG::DEFAULT, std::ostream &_out = std::cout);
+
+    void outHeader();
+    void outRow();
+
+    // fold the lucks of z-trial z into the z stats
+    void zAdd(int z, const ZLuck &luck);
+
+    // does the SPRT reject uniformity after the z-trials added so far?
+    bool rejects() const;
+
+    // the z stats of cfg, without printing; stops early if rejects()
+    void run();
+
+    // run, then print the row (after the header for the first row)
+    void row();
+  };
+
+  // DeckConfig spaces the sweeps explore
+  std::vector<DeckConfig> top40Configs();
+  std::vector<DeckConfig> configs();
+  std::vector<DeckConfig> configsCutEasy();
+  std::vector<DeckConfig> configsCutEasy2();
+}
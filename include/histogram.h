@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace spider {
+
+  //
+  // Counts of symbols, or of tuples of symbols, from [0,bins), for the
+  // chi-square "luck" of a stream.
+  //
+  // The bins^dims counts are one contiguous cache line aligned table,
+  // reset in place between trials.  The sum of the squared counts is
+  // kept as counts are added, so chi2() and z() are O(1) instead of a
+  // pass over the table.
+  //
+  // Tables are filled either by cell, with add(cell(a,b,...)), or from
+  // a stream of symbols with push(x): once enough symbols have been
+  // seen, push counts the tuple (x[t-(dims-1)*lag], ..., x[t-lag], x[t]).
+  // every > 1 counts only every every-th tuple, so every == dims counts
+  // non-overlapping tuples.
+  //
+  struct Histogram {
+    Histogram(int bins, int dims=1, int lag=1, int every=1);
+    Histogram(const Histogram &copy);
+    Histogram(Histogram &&move);
+    Histogram& operator=(const Histogram &copy);
+    Histogram& operator=(Histogram &&move);
+    ~Histogram();
+
+    int bins() const { return m_bins; }
+    int dims() const { return m_dims; }
+    size_t cells() const { return m_cells; }
+    uint64_t total() const { return m_total; }
+    uint32_t operator[](size_t cell) const { return m_counts[cell]; }
+
+    // zero the counts and forget the pushed symbols
+    void reset();
+
+    size_t cell(int a) const { return a; }
+    size_t cell(int a, int b) const { return size_t(a)*m_bins+b; }
+    size_t cell(int a, int b, int c) const { return cell(a,b)*m_bins+c; }
+    size_t cell(int a, int b, int c, int d) const { return cell(a,b,c)*m_bins+d; }
+
+    void add(size_t cell) {
+      uint32_t count = m_counts[cell]++;
+      m_squares += 2*uint64_t(count)+1;
+      ++m_total;
+    }
+
+    void push(int symbol) {
+      m_history[m_head] = symbol;
+      if (++m_head == m_span) m_head = 0;
+      if (m_seen < m_span && ++m_seen < m_span) return;
+      if (m_skip > 0) {
+	--m_skip;
+	return;
+      }
+      m_skip = m_every-1;
+
+      // the oldest symbol is at the head again
+      size_t cell = 0;
+      int at = m_head;
+      for (int d=0; d<m_dims; ++d) {
+	cell = cell*m_bins + m_history[at];
+	at += m_lag;
+	if (at >= m_span) at -= m_span;
+      }
+      add(cell);
+    }
+
+    // sum of (count-mu)^2/mu over the cells, mu = total/cells
+    double chi2() const;
+
+    // normal approximation of chi2, about N(0,1) for a uniform stream:
+    // sqrt(2)*(sqrt(chi2)-sqrt(cells-1.5))
+    double z() const;
+
+    // sum of the squared counts, recomputed from the table
+    uint64_t squares() const;
+
+    int m_bins;
+    int m_dims;
+    int m_lag;
+    int m_every;
+    size_t m_cells;
+    uint32_t *m_counts;
+    uint64_t m_total;
+    uint64_t m_squares;
+
+    // the last span = (dims-1)*lag+1 symbols, a ring written at head
+    std::vector<int> m_history;
+    int m_span;
+    int m_head;
+    int m_seen;
+    int m_skip;
+  };
+}
@@ -16,55 +16,17 @@ T* retain_thread_local_storage<T>::m_value = 0;
 
 #else
 
-#include <new>
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <pthread.h>
-#endif
-
+// one slot per thread and type: a plain load, no key lookup
 template <typename T>
 class retain_thread_local_storage
 {
-#ifdef _WIN32
-private: typedef DWORD key_t;
-#else
-private: typedef pthread_key_t key_t;
-#endif
-
-private: static key_t s_key;
-private: static key_t key_init()
-  {
-#ifdef _WIN32
-    if ((s_key = TlsAlloc()) == TLS_OUT_OF_INDEXES) 
-      throw std::bad_alloc();
-#else
-    if (pthread_key_create(&s_key,0) != 0) 
-      throw std::bad_alloc();
-#endif
-    return s_key;
-  }
-
-public: static inline T* get() 
-  {
-#ifdef _WIN32
-    return (T*) TlsGetValue(s_key);
-#else
-    return (T*) pthread_getspecific(s_key);
-#endif
-  }
-
-public: static inline void set(T* value) 
-  {
-#ifdef _WIN32
-    TlsSetValue(s_key,value);
-#else
-    pthread_setspecific(s_key,value);
-#endif
-  }
+private: static thread_local T* s_value;
+public: static inline T* get() { return s_value; }
+public: static inline void set(T* value) { s_value=value; }
 };
 
-template <typename T> typename retain_thread_local_storage<T>::key_t retain_thread_local_storage<T>::s_key = retain_thread_local_storage<T>::key_init();
+template <typename T>
+thread_local T* retain_thread_local_storage<T>::s_value = 0;
 
 #endif
 
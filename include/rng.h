@@ -1,25 +1,125 @@
 #pragma once
 
 #include <stdint.h>
-#include <fstream>
+#include <stddef.h>
 
 namespace spider {
 
+  // Lemire's multiply-shift: uniform in [0,n) from rng.next_u32(), the
+  // only division is on the (rare) path that may reject.
+  template <typename Generator>
+  inline uint32_t lemire(Generator &rng, uint32_t n) {
+    uint64_t m = uint64_t(rng.next_u32()) * uint64_t(n);
+    uint32_t low = uint32_t(m);
+    if (low < n) {
+      uint32_t threshold = uint32_t(-n) % n;
+      while (low < threshold) {
+	m = uint64_t(rng.next_u32()) * uint64_t(n);
+	low = uint32_t(m);
+      }
+    }
+    return uint32_t(m >> 32);
+  }
+
+  //
+  // A generator is anything with next_u32(), next_u32(n) and next(a,b).
+  // Templates over the generator (Deck::shuffle, Solitaire::shuffle)
+  // inline the draws of the FastRNG generators below; RNG& callers
+  // go through this virtual interface.
+  //
   struct RNG {
     static RNG &DEFAULT;
     virtual uint32_t next_u32() = 0;
   
     virtual uint32_t next_u32(uint32_t n);  
     int next(int a, int b);
+
+    // n next_u32() values at once
+    virtual void fill(uint32_t *words, size_t n);
     virtual ~RNG();
   };
 
-  // use /dev/urand
+  // use the os (getrandom(), or /dev/urandom without it).  Words come
+  // from a per thread buffer refilled a block at a time, and are wiped
+  // as they are used.  A forked child drops the buffer it inherits.
   struct OS_RNG : RNG {
-    std::ifstream urand;
     OS_RNG();
     ~OS_RNG();
     uint32_t next_u32();
+    void fill(uint32_t *words, size_t n);
+  };
+
+  // Base for generators whose next_u32() is final: the bounded draws
+  // call it directly, so they inline when the generator type is known.
+  template <typename Self>
+  struct FastRNG : RNG {
+    uint32_t next_u32(uint32_t n) final { return lemire(static_cast<Self&>(*this),n); }
+    int next(int a, int b) { return a + int((b>a) ? next_u32(uint32_t(b-a+1)) : 0); }
+  };
+
+  inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  // splitmix64: seedable and reproducible, for independent streams
+  // (one per trial) whose results do not depend on who runs them.
+  struct SPLITMIX_RNG final : FastRNG<SPLITMIX_RNG> {
+    uint64_t m_state;
+    SPLITMIX_RNG(uint64_t seed=0) : m_state(seed) {}
+
+    uint64_t next_u64() {
+      uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    using FastRNG<SPLITMIX_RNG>::next_u32;
+    uint32_t next_u32() final { return uint32_t(next_u64() >> 32); }
+  };
+
+  // xoshiro256** (Blackman, Vigna): a fast seedable generator with a
+  // 2^256-1 period.  Each 64 bit output is used as two 32 bit words,
+  // high half first.  jump() advances 2^128 outputs, so copies jumped
+  // 0,1,2,... times are non-overlapping streams; long_jump() advances
+  // 2^192 for streams of streams.
+  struct XOSHIRO_RNG final : FastRNG<XOSHIRO_RNG> {
+    uint64_t m_state[4];
+    uint32_t m_spare;
+    bool m_spared;
+
+    // state seeded from splitmix64(seed), as the authors recommend
+    XOSHIRO_RNG(uint64_t seed=0);
+    XOSHIRO_RNG(uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3);
+
+    uint64_t next_u64() {
+      uint64_t *s = m_state;
+      uint64_t result = rotl(s[1] * 5, 7) * 9;
+      uint64_t t = s[1] << 17;
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = rotl(s[3], 45);
+      return result;
+    }
+
+    using FastRNG<XOSHIRO_RNG>::next_u32;
+    uint32_t next_u32() final {
+      if (m_spared) {
+	m_spared = false;
+	return m_spare;
+      }
+      uint64_t x = next_u64();
+      m_spare = uint32_t(x);
+      m_spared = true;
+      return uint32_t(x >> 32);
+    }
+
+    void fill(uint32_t *words, size_t n);
+    void jump();
+    void long_jump();
   };
 
   // produce 1,2,3,etc.
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <string>
 #include <vector>
-#include <set>
 
 #include "card.h"
 #include "deck.h"
+#include "search_set.h"
 
 namespace spider {
   struct SearchSetCmp {
@@ -12,32 +16,196 @@ namespace spider {
       return equivalent(a,b) < 0;
     }
   };
-  typedef std::set<Deck,SearchSetCmp> SearchSet;
   
+  // one level of a Search, for Search::progress
+  struct SearchProgress {
+    int dist;
+    bool isForward;
+    // states in each boundary and both visited sets after the level
+    size_t fboundary, rboundary, visited;
+    // decks made, and how many of them were states seen before
+    uint64_t children, duplicates;
+    // time the level took, and bytes of all the sets after it
+    double seconds;
+    size_t bytes;
+
+    double statesPerSecond() const { return seconds > 0 ? children/seconds : 0; }
+    double duplicateRate() const { return children > 0 ? double(duplicates)/children : 0; }
+  };
+
   struct Search {
     int cards;
+    // levels grown in all, and from each side
     int maxDist,dist,fdist,rdist;
     int duplicates;
     double growth;
     bool all;
-    SearchSet forward,fboundary;
-    SearchSet reverse,rboundary;
+    // grow() takes the side whose next level costs less: its boundary
+    // states times the cost of a child, an unmix child costing
+    // unmixCost mix children.  unmixCost is a fixed setting (1.6 from
+    // one offline timing), not measured as the search runs, so the
+    // side taken and the paths do not depend on timing.  Every deck
+    // has n children and n parents, so on searches that start with one
+    // deck a side this is plain alternation and saves nothing; it only
+    // helps once the sides are out of step (a resumed or hand grown
+    // search).  Without balance it alternates.
+    bool balance;
+    double unmixCost;
+    // children made by each side
+    uint64_t fexpansions, rexpansions;
+    // workers expanding each level; paths do not depend on it
+    int threads;
+    SearchShards forward,fboundary;
+    SearchShards reverse,rboundary;
+    // read back through the links of the visited states: the first
+    // path found, or with all every shortest path through each level
     std::vector < std::vector<Card> > paths;
+    // with all, stop after the first level with paths: every shortest
+    // path and no longer ones
+    bool shortest;
+    // If set, each path goes to onPath as it is read back instead of
+    // into paths, one at a time; returning false halts the search.
+    // Each word comes once: a word crosses a level at one edge.
+    std::function<bool(const std::vector<Card> &)> onPath;
+    // with no onPath, count the paths through the links without
+    // reading any back
+    bool countOnly;
+    // paths found, read back or counted
+    uint64_t count;
 
+    // the config from and to were bound to when the search began, kept
+    // here so the workers and later calls do not depend on its owner
+    DeckConfig config;
     Deck from;
     Deck to;
 
+    // called after each level
+    std::function<void(const SearchProgress &)> progress;
+    // find() stops before a level that would pass either budget (0
+    // for none): seconds in this find(), or bytes of the sets.  It
+    // sets stopped; find() again goes on.  onPath halts in the middle
+    // of a level instead: find() does not go on, and save() refuses
+    // the search.
+    double maxSeconds;
+    size_t maxBytes;
+    bool stopped;
+
     Search(const Deck &_from, const Deck &_to);
+    // from, to and the sets point at config
+    Search(const Search &copy) = delete;
+    Search &operator=(const Search &copy) = delete;
     bool done() const;
     bool found() const;
+    // did onPath halt the search
+    bool halted() const { return m_halted; }
     void grow();
     void find();
     void growReverse();
     void growForward();
+
+    // bytes of the visited and boundary sets
+    size_t bytes() const;
+
+    // The decks, config, sets, paths and counts to a file, and back into
+    // this search (of any decks and config) to go on where it stopped,
+    // under the config it began with.  A halted search is part way
+    // through a level and cannot be saved.  Throws std::runtime_error
+    // for it, or if the file cannot be written or read.
+    void save(const std::string &path) const;
+    void load(const std::string &path);
+
+  private:
+    // a boundary deck (shard, record) whose card child is record
+    // otherRecord of shard otherShard of the other boundary
+    struct Meet {
+      int shard;
+      size_t record;
+      int card;
+      int otherShard;
+      size_t otherRecord;
+    };
+    // what one worker found in a level
+    struct Expansion {
+      std::vector< std::vector<uint8_t> > records;
+      std::vector<Meet> meets;
+      int duplicates = 0;
+      // children made, fewer than cards per state once stopped
+      uint64_t children = 0;
+    };
+    void expand(bool isForward);
+    // the side grow() takes next
+    bool nextIsForward() const;
+    // would the next level pass a budget
+    bool overBudget(double seconds) const;
+    void report(bool isForward, uint64_t children, uint64_t duplicates, double seconds);
+
+    // A visited state links to the state it was reached from, as
+    // (card+1) << 40 | shard << 32 | record in the visited set of its
+    // side; 0 for from and to themselves.
+    static uint64_t link(int shard, size_t record, int card) {
+      return (uint64_t(card+1) << 40) | (uint64_t(shard) << 32) | uint64_t(record);
+    }
+    // the (shard, record, card) order of the edges of a level, as one
+    // number: the order a single worker makes them in
+    static uint64_t edgeOrder(int shard, size_t record, int card) {
+      return (uint64_t(shard) << 40) | (uint64_t(record) << 8) | uint64_t(card);
+    }
+    static uint64_t edgeOrder(uint64_t link) {
+      return edgeOrder(int((link >> 32) & 0xff),size_t(link & 0xffffffff),int(link >> 40)-1);
+    }
+    // each way through the links from record of set back to from
+    // (isForward) or to, as the cards nearest the state first; false
+    // from each stops
+    bool eachWay(const SearchSet &set, size_t record, bool isForward, std::vector<Card> &cards, const std::function<bool(const std::vector<Card> &)> &each) const;
+    // onPath asked to stop
+    bool m_halted;
+    // the number of those ways, remembered by state for the level
+    uint64_t ways(const SearchSet &set, size_t record, bool isForward);
+    std::map< std::pair<const SearchSet*,size_t>, uint64_t > m_ways;
+    // the paths through the edge before --card--> after; false if
+    // onPath stopped
+    bool addPaths(const SearchSet &fset, size_t before, const Card &card, const SearchSet &rset, size_t after);
   };
 
+  // The cut locations of a word of fromDist cut + back-front shuffles
+  // from `from` followed by toDist more to `to` (or fewer, if a prefix
+  // already gets there), added around path.  The first such word in
+  // depth first order; cycle asks for at least one step.  Reverse
+  // steps past what fits in SEARCH_LITE_TABLE_BYTES move to the
+  // forward walk: the words of each length are the same, but the first
+  // one is then taken in the order of that split, and can differ from
+  // the one SearchLiteDepthFirst finds.
   bool SearchLite(const Deck &from, int fromDist, 
 		  const Deck &to, int toDist, 
 		  std::vector<int> &path, bool cycle=false);
 
+  // Bytes a SearchLite table may take; SearchLite, SearchLiteParallel
+  // and SearchLiteAll walk the reverse steps past it forward instead.
+  const size_t SEARCH_LITE_TABLE_BYTES = size_t(1) << 30;
+
+  // the most reverse steps, up to toDist, whose SearchLite table of to
+  // fits in SEARCH_LITE_TABLE_BYTES; -1 if not even to itself does
+  int SearchLiteTableDist(const Deck &to, int toDist);
+
+  // the plain depth first recursion, n^(fromDist+toDist) steps
+  bool SearchLiteDepthFirst(const Deck &from, int fromDist, 
+			    const Deck &to, int toDist, 
+			    std::vector<int> &path, bool cycle=false);
+
+  // SearchLite on threads (0 for all the hardware has): the top levels
+  // of the forward walk are tasks on a work stealing pool, and each
+  // task walks the rest depth first on decks on its stack.  A word
+  // found cancels the tasks after it in depth first order, so the path
+  // is the one SearchLite finds.
+  bool SearchLiteParallel(const Deck &from, int fromDist,
+			  const Deck &to, int toDist,
+			  std::vector<int> &path, bool cycle=false, int threads=0);
+
+  // Every word of the fewest cut + back-front shuffles (at most
+  // maxDist) from `from` to `to`, in order, walked like
+  // SearchLiteParallel.  The number of steps, or -1 if there is none;
+  // cycle asks for at least one step.
+  int SearchLiteAll(const Deck &from, const Deck &to, int maxDist,
+		    std::vector< std::vector<int> > &paths, bool cycle=false, int threads=0);
+
 }
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include "card.h"
+#include "deck.h"
+#include "deck_codec.h"
+
+namespace spider {
+
+  //
+  // Bidirectional breadth first search like Search, with the levels on
+  // disk instead of in SearchSets, for searches whose visited states do
+  // not fit in memory.
+  //
+  // Each level of each direction is a file of sorted, unique DeckCodec
+  // keys.  Growing a side streams its frontier, buffering child keys up
+  // to the memory budget and writing each full buffer as a sorted run;
+  // the runs are then merged (in several passes if there are more than
+  // the budget can read at once) in one streaming pass that also
+  //
+  //   - drops keys already in a visited level of that side, and
+  //   - merge-joins the children against the other side's frontier to
+  //     find where they meet.
+  //
+  // Paths are read back by scanning the levels for the edges into the
+  // meeting states, so memory stays around the budget whatever the
+  // size of the levels.  Files go in dir and are removed with the
+  // search.
+  //
+  struct SearchDisk {
+    int cards;
+    int maxDist,dist;
+    uint64_t duplicates;
+    double growth;
+    bool all;
+
+    // bytes for sort and merge buffers
+    size_t memory;
+    std::string dir;
+    DeckCodec codec;
+
+    // states per level, from the start of each side
+    std::vector<uint64_t> forward, reverse;
+    // sorted runs written so far
+    uint64_t runs;
+
+    std::vector < std::vector<Card> > paths;
+
+    // the config from and to were bound to when the search began;
+    // every deck read back from the levels is bound to it
+    DeckConfig config;
+    Deck from;
+    Deck to;
+
+    SearchDisk(const Deck &_from, const Deck &_to, const std::string &dir="/tmp", size_t memory=size_t(256)<<20, DeckCodec::Format format=DeckCodec::RANK);
+    ~SearchDisk();
+    SearchDisk(const SearchDisk &copy) = delete;
+    SearchDisk& operator=(const SearchDisk &copy) = delete;
+
+    bool done() const;
+    bool found() const;
+    void grow();
+    void find();
+    void growReverse();
+    void growForward();
+
+    // bytes of level and run files on disk now
+    uint64_t bytesOnDisk() const;
+
+  private:
+    std::string m_prefix;
+    int m_files;
+    std::vector<std::string> m_forward, m_reverse;
+
+    std::string tempName();
+    void growSide(bool isForward);
+    // the runs of the children of the frontier, and their count
+    std::vector<std::string> expand(bool isForward, uint64_t &children);
+    std::vector<std::string> reduce(std::vector<std::string> runs);
+    void pathsTo(bool isForward, const std::vector<uint8_t> &meets);
+    std::vector<Card> forwardPath(Deck deck, int level);
+    std::vector<Card> reversePath(Deck deck, int level);
+    bool contains(const std::string &level, const uint8_t *key);
+  };
+}
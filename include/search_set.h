@@ -0,0 +1,243 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <unordered_map>
+
+#include "card.h"
+#include "deck.h"
+#include "deck_codec.h"
+
+namespace spider {
+
+  //
+  // A set of decks up to equivalent(): decks that are rotations of each
+  // other past their leading J,Q,K and jokers are the same state.
+  //
+  // Each state is stored once as its DeckCodec key (by default 6 bits
+  // per card, 30 bytes at n=40; the Lehmer rank is 20 bytes but costs
+  // more per lookup), plus the rotation so the first deck inserted
+  // comes back exactly.  Keys are carved from a bump arena of fixed
+  // size records and found through an open addressing (linear probing)
+  // table of 8 byte slots holding a hash tag and the record number.  There is no per state allocation.
+  //
+  // Iteration is in insertion order and yields decks by value.  All
+  // the decks of a set have the same size; the first one inserted also
+  // sets the index and config binding of the decks handed back.
+  //
+  // A linked set also keeps a 64 bit link in each record, for a search
+  // to say how it reached the state, and any further links added for
+  // a state in a side table.  A set that does not rotate holds decks
+  // up to == rather than equivalent().
+  //
+  class SearchSet {
+  public:
+    class const_iterator {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef Deck value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const Deck* pointer;
+      typedef Deck reference;
+
+      const_iterator(const SearchSet *set=0, size_t record=0) : m_set(set), m_record(record) {}
+      Deck operator*() const { return m_set->deck(m_record); }
+      const_iterator& operator++() { ++m_record; return *this; }
+      const_iterator operator++(int) { const_iterator was(*this); ++m_record; return was; }
+      bool operator==(const const_iterator &to) const { return m_record == to.m_record; }
+      bool operator!=(const const_iterator &to) const { return m_record != to.m_record; }
+      const SearchSet* set() const { return m_set; }
+      size_t record() const { return m_record; }
+    private:
+      const SearchSet *m_set;
+      size_t m_record;
+    };
+    typedef const_iterator iterator;
+
+    SearchSet(DeckCodec::Format format=DeckCodec::PACKED, bool linked=false, bool rotate=true);
+    SearchSet(const SearchSet &copy);
+    SearchSet(SearchSet &&move);
+    SearchSet& operator=(const SearchSet &copy);
+    SearchSet& operator=(SearchSet &&move);
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    void clear();
+    void swap(SearchSet &with);
+
+    // true if deck was not already in the set
+    bool insert(const Deck &deck);
+    template <typename Iterator>
+    void insert(Iterator first, Iterator last) {
+      while (first != last) insert(*first++);
+    }
+    // the records of another set, without unpacking them
+    void insert(const_iterator first, const_iterator last);
+
+    const_iterator find(const Deck &deck) const;
+    size_t count(const Deck &deck) const { return find(deck) != end() ? 1 : 0; }
+
+    const_iterator begin() const { return const_iterator(this,0); }
+    const_iterator end() const { return const_iterator(this,m_size); }
+
+    // the deck of record i, as it was first inserted
+    Deck deck(size_t record) const;
+
+    // memory held by the table and the arena
+    size_t bytes() const;
+    double bytesPerState() const { return m_size > 0 ? double(bytes())/m_size : 0; }
+
+    // Records (the rotation byte, then the key) made once and used with
+    // several sets of the same deck size and format.  shape() takes the
+    // deck size and prototype from deck if the set has none yet.
+    static const size_t MAX_RECORD_BYTES = 1 + DeckCodec::MAX_BYTES + sizeof(uint64_t);
+    void shape(const Deck &deck);
+    size_t recordBytes() const { return m_recordBytes; }
+    void pack(const Deck &deck, uint8_t *record, uint64_t link=0) const;
+    uint64_t hash(const uint8_t *record) const { return hashKey(record+1); }
+    bool insertRecord(const uint8_t *record, uint64_t hash);
+    const_iterator findRecord(const uint8_t *record, uint64_t hash) const;
+    bool containsRecord(const uint8_t *record, uint64_t hash) const {
+      return findRecord(record,hash) != end();
+    }
+    int cards() const { return m_cards; }
+
+    bool linked() const { return m_linked; }
+    // the link the state was inserted with
+    uint64_t link(size_t record) const;
+    // that and the links added since
+    void links(size_t record, std::vector<uint64_t> &out) const;
+    void addLink(size_t record, uint64_t link);
+
+    // The records and links, in order, to a file and back: false if
+    // the file fails or holds a set of another format.  read() replaces
+    // the set and takes the deck prototype from like.
+    bool write(FILE *file) const;
+    bool read(FILE *file, const Deck &like);
+
+  private:
+    DeckCodec::Format m_format;
+    DeckCodec m_codec;
+    bool m_linked;
+    bool m_rotate;
+
+    // prototype of the stored decks
+    int m_cards;
+    bool m_indexed;
+    const DeckConfig *m_bound;
+
+    // record: rotation byte, the key, then the link if linked.  Chunk
+    // k of the arena holds 64 << k records, so small sets stay small.
+    size_t m_keyBytes;
+    size_t m_recordBytes;
+    std::vector< std::unique_ptr<uint8_t[]> > m_chunks;
+    size_t m_size;
+
+    // 0 empty, else hash tag << 32 | record+1
+    std::vector<uint64_t> m_slots;
+    size_t m_mask;
+
+    // links past the first, by record
+    std::unordered_multimap<uint32_t,uint64_t> m_more;
+
+    const uint8_t* record(size_t i) const;
+    uint8_t* append();
+    uint64_t hashKey(const uint8_t *key) const;
+    // the slot holding key, or the empty slot where it goes
+    size_t probe(const uint8_t *key, uint64_t hash) const;
+    void rehash(size_t capacity);
+  };
+
+  inline void swap(SearchSet &a, SearchSet &b) { a.swap(b); }
+
+  //
+  // A SearchSet split into SHARDS sets by the top bits of the record
+  // hash.  Each shard is an ordinary SearchSet: any number of threads
+  // may look records up while none inserts, and threads that own
+  // disjoint shards may insert into them at the same time, with no
+  // locks.  Iteration is shard by shard, each in insertion order.
+  //
+  class SearchShards {
+  public:
+    static const int SHARDS = 64;
+
+    class const_iterator {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef Deck value_type;
+      typedef ptrdiff_t difference_type;
+      typedef const Deck* pointer;
+      typedef Deck reference;
+
+      const_iterator(const SearchShards *shards=0, int shard=SHARDS, size_t record=0) : m_shards(shards), m_shard(shard), m_record(record) { skip(); }
+      Deck operator*() const { return m_shards->shard(m_shard).deck(m_record); }
+      const_iterator& operator++() { ++m_record; skip(); return *this; }
+      const_iterator operator++(int) { const_iterator was(*this); ++*this; return was; }
+      bool operator==(const const_iterator &to) const { return m_shard == to.m_shard && m_record == to.m_record; }
+      bool operator!=(const const_iterator &to) const { return !(*this == to); }
+      int shard() const { return m_shard; }
+      size_t record() const { return m_record; }
+    private:
+      const SearchShards *m_shards;
+      int m_shard;
+      size_t m_record;
+      void skip() {
+	while (m_shard < SHARDS && m_record >= m_shards->shard(m_shard).size()) {
+	  ++m_shard;
+	  m_record = 0;
+	}
+      }
+    };
+    typedef const_iterator iterator;
+
+    SearchShards(DeckCodec::Format format=DeckCodec::PACKED, bool linked=false);
+
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    void clear();
+    void swap(SearchShards &with);
+
+    SearchSet& shard(int i) { return m_shards[i]; }
+    const SearchSet& shard(int i) const { return m_shards[i]; }
+    static int shardOf(uint64_t hash) { return hash >> 58; }
+
+    bool insert(const Deck &deck);
+    template <typename Iterator>
+    void insert(Iterator first, Iterator last) {
+      while (first != last) insert(*first++);
+    }
+    // every record of from, one thread per group of shards
+    void insert(const SearchShards &from, int threads=1);
+
+    const_iterator find(const Deck &deck) const;
+    size_t count(const Deck &deck) const { return find(deck) != end() ? 1 : 0; }
+
+    const_iterator begin() const { return const_iterator(this,0,0); }
+    const_iterator end() const { return const_iterator(this,SHARDS,0); }
+
+    // as in SearchSet; shape() shapes every shard alike
+    void shape(const Deck &deck);
+    size_t recordBytes() const { return m_shards[0].recordBytes(); }
+    void pack(const Deck &deck, uint8_t *record, uint64_t link=0) const { m_shards[0].pack(deck,record,link); }
+    uint64_t hash(const uint8_t *record) const { return m_shards[0].hash(record); }
+    bool containsRecord(const uint8_t *record, uint64_t hash) const {
+      return m_shards[shardOf(hash)].containsRecord(record,hash);
+    }
+
+    size_t bytes() const;
+    double bytesPerState() const { return size() > 0 ? double(bytes())/size() : 0; }
+
+    // every shard in turn, as SearchSet::write() and read()
+    bool write(FILE *file) const;
+    bool read(FILE *file, const Deck &like);
+
+  private:
+    std::vector<SearchSet> m_shards;
+  };
+
+  inline void swap(SearchShards &a, SearchShards &b) { a.swap(b); }
+}
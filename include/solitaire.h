@@ -14,6 +14,8 @@ namespace spider {
     int find(int card) const;
     Solitaire();
     void shuffle(RNG &rng);
+    template <typename Generator>
+    void shuffle(Generator &rng);
     int pad() const;
     bool valid() const;
     void down1(int card);
@@ -21,5 +23,12 @@ namespace spider {
     void countCut(int count);
     void next();
   };
-}
 
+  template <typename Generator>
+  void Solitaire::shuffle(Generator &rng) {
+    for (int i=0; i<N; ++i) {
+      int j=rng.next(i,N-1);
+      swap(i,j);
+    }
+  }
+}
@@ -59,6 +59,31 @@
   /* determine cipher pad card fron deck */
   Card deckCipherPad(Deck deck);
 
+  /* one implementation of the fixed-time deck kernels behind
+     deckFindCard, deckCipherPad and deckPseudoShuffle */
+  struct DeckKernelTable {
+    const char *name;
+    /* non-zero if this cpu can run the kernel */
+    int (*supported)(void);
+    int (*findCard)(Deck deck, Card card);
+    Card (*cipherPad)(Deck deck);
+    void (*pseudoShuffle)(Deck deck, int cutLoc);
+  };
+
+  /* portable scalar kernels (FIND macros, deckCut, deckBackFrontShuffle) */
+  extern const DeckKernelTable DECK_KERNEL_SCALAR;
+  /* x86 SSE4.1 and AVX2 kernels, compare and shuffle masks only, so
+     no branch or memory address depends on the deck or cards */
+  extern const DeckKernelTable DECK_KERNEL_SSE4;
+  extern const DeckKernelTable DECK_KERNEL_AVX2;
+
+  /* kernel in use; the fastest supported one unless set by deckUseKernel */
+  const DeckKernelTable *deckKernel(void);
+
+  /* use the given kernel, returns -1 (and changes nothing) if this cpu
+     does not support it */
+  int deckUseKernel(const DeckKernelTable *kernel);
+
   /* encrypt (mode 1) or decrypt (mode -1) input and pseudo-shuffle deck,
      OutputCard can be null; this saves time if the result is not
      needed (for example, to key a deck) */
@@ -92,9 +117,12 @@
   
   void CardArrayIOInit(CardArrayIO *me, Card *cards, int step, int size, int capacity);
 
+  /* uniformly random cards from the os, by rejection sampling the
+     bytes of buffered OS_RNG words */
   struct CardRandIO {
     CardIO base;
-    FILE *urand;
+    uint32_t word;
+    int bytes;
   };
 
   void CardRandIOInit(CardRandIO *me);
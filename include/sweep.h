@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+
+#include "deck.h"
+#include "deck_stats.h"
+
+namespace spider {
+
+  // one DeckStats row of a sweep
+  struct SweepItem {
+    int n;
+    DeckConfig cfg;
+
+    // "n,cipherZth,cipherOffset,cutZth,cutOffset", the start of its row
+    std::string key() const;
+  };
+
+  //
+  // A sweep of DeckStats rows over every (n, cfg) of ns x cfgs.
+  //
+  // The items are dealt to shards round robin, so independent
+  // processes running shard 0..shards-1 of the same sweep cover it
+  // exactly once; within a process DeckStats runs the z-trials of each
+  // item on threads.
+  //
+  // The csv at path starts with a "# " settings line and the header,
+  // then each row is appended and synced as soon as it is done.
+  // resume() reads back the complete rows of an interrupted run
+  // (dropping a torn last line) and run() skips those items.  Every item
+  // seeds its own rng from (seed, n, cfg), so the rows do not depend on
+  // sharding, threads or restarts.
+  //
+  struct Sweep {
+    std::vector<int> ns;
+    std::vector<DeckConfig> cfgs;
+
+    int shard;
+    int shards;
+
+    std::string path;
+    uint64_t seed;
+
+    int zTrials;
+    int tTrials;
+    int messageLen;
+    int threads;
+    bool batch;
+
+    // DeckStats early stopping, off when 0
+    double sprtAlpha;
+    double sprtDelta;
+
+    // keys of the rows already in path
+    std::set<std::string> done;
+
+    Sweep();
+
+    // the items of this shard, in sweep order
+    std::vector<SweepItem> items() const;
+
+    // the rng seed of one item
+    uint64_t itemSeed(const SweepItem &item) const;
+
+    // load the complete rows of path into done, truncating a partial
+    // last line; returns the number of rows kept.  Throws runtime_error,
+    // leaving path alone, on other settings, a foreign header or a bad
+    // row before the last line.
+    int resume();
+
+    // run the items of this shard not yet done; returns the rows added
+    int run(std::ostream &log = std::cerr);
+
+    // "# zTrials=..,tTrials=..,messageLen=..,seed=..,sprtAlpha=..,sprtDelta=..",
+    // the first line of path
+    std::string settings() const;
+
+    static std::string header();
+  };
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+#include "deck.h"
+
+// DeckConfig grid shared by the tests, including the edge offsets -1 and 0.
+inline std::vector<spider::DeckConfig> testConfigs() {
+  std::vector<spider::DeckConfig> cfgs;
+  spider::DeckConfig cfg;
+  for (auto cipherZth : {0,1,2,3,4,5}) {
+    cfg.cipherZth = cipherZth;
+    for (auto cipherOffset : {-1,0,1,2,3,4,5,35,36,37,38,39}) {
+      cfg.cipherOffset=cipherOffset;
+      for (auto cutZth : {0,1,2,3,4,5}) {
+	cfg.cutZth = cutZth;
+	for (auto cutOffset : {-1,0,1,2,3,4,5,35,36,37,38,39}) {
+	  cfg.cutOffset=cutOffset;
+	  cfgs.push_back(cfg);
+	}
+      }
+    }
+  }
+  return cfgs;
+}
+
+// Every stride'th config of testConfigs(); a stride coprime to 6 and 12
+// still visits every value of each field.
+inline std::vector<spider::DeckConfig> testConfigs(size_t stride) {
+  std::vector<spider::DeckConfig> all = testConfigs(),cfgs;
+  for (size_t i=0; i<all.size(); i += stride) cfgs.push_back(all[i]);
+  return cfgs;
+}
@@ -9,7 +9,6 @@
 
 namespace spider {
   Card::Card() : order(0) {}
-  Card::Card(const Card &card) : order(card.order) {}
   Card::Card(uint8_t _order) : order(_order) {}
 
   uint8_t Card::suiteNumber() const {
@@ -83,9 +82,6 @@ namespace spider {
   bool Card::operator>(const Card &to) const {
     return order > to.order;
   }
-  void Card::operator=(const Card &card) {
-    order = card.order;
-  }
 
   const char * const Card::SUITES[] = { "C","D","H","S","J" };
   const char * const Card::FACES[] = { "Q","A","2","3","4","5","6","7","8","9", "10", "J", "K" };
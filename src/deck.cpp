@@ -22,90 +22,54 @@ namespace spider {
 
   const DeckConfig DeckConfig::DEFAULT;
 
-  int Deck::padLoc(const std::vector<Card> &cards, int zth, int offset, int modulus) {
-    int zthLoc = forward(cards,0,zth);
-    if (offset >= 0) {
-      Card markCard=spider::addMod(cards[zthLoc],Card(offset),modulus);
-      int markLoc = find(cards,markCard);
-      int padLoc = forward(cards,markLoc,1);
-      return padLoc;
-    } else {
-      return zthLoc;
-    }
-  }
-
-  unsigned Deck::forward(const std::vector<Card> &cards, unsigned loc, unsigned delta) {
-    unsigned n = cards.size();
-    for (;;) {
-      while (cards[loc].order >= 40) {
-	++loc;
-	if (loc >= n) { loc = 0; }
-      }
-      if (delta == 0) return loc;
-      --delta;
-      ++loc;
-      if (loc >= n) { loc = 0; }      
+  int Deck::modulus() const { return cards.size() == 10 ? 10 : 40; }
+  void Deck::reset() {
+    for (size_t i=0; i<cards.size(); ++i) {
+      cards[i]=Card(i);
     }
+    if (indexed) index();
   }
 
-  unsigned Deck::back(const std::vector<Card> &cards, unsigned loc, unsigned delta) {
-    unsigned n = cards.size();
-    for (;;) {
-      while (cards[loc].order >= 40) {
-	if (loc == 0) { loc = n; }
-	--loc;
-      }
-      if (delta == 0) return loc;
-      --delta;
-      if (loc == 0) { loc = n; }
-      --loc;
+  void Deck::index() {
+    for (size_t i=0; i<cards.size(); ++i) {
+      locs[cards[i].order]=i;
     }
+    indexed = true;
   }
 
-  int Deck::modulus() const { return cards.size() == 10 ? 10 : 40; }
-  void Deck::reset() {
-    for (size_t i=0; i<cards.size(); ++i) {
-      cards[i]=Card(i);
-    }
+  void Deck::unindex() {
+    indexed = false;
   }
 
   void Deck::shuffle(RNG &rng) {
-    int n=cards.size();
-    for (int i=0; i<n; ++i) {
-      int j=rng.next(i,n-1);
-      Card tmp=cards[i];
-      cards[i]=cards[j];
-      cards[j]=tmp;
-    }
+    shuffle<RNG>(rng);
   }
   
 
-  Deck::Deck(size_t size) : cards(size) {
+  Deck::Deck(size_t size) : cards(size), indexed(false), bound(0) {
+    assert(size <= MAX_SIZE);
     for (size_t i=0; i<size; ++i) {
       cards[i]=Card(i);
     }
   }
 
-  int Deck::find(const std::vector<Card> &cards, const Card &card) {
-    auto loc = std::find(std::begin(cards), std::end(cards), card);
-    return (loc != std::end(cards)) ? loc-std::begin(cards) : -1;
-  }
-  
   int Deck::find(const Card &card) const {
+    if (indexed) {
+      return (card.order < cards.size()) ? locs[card.order] : -1;
+    }
     return find(cards,card);
   }
 
-  const Card& Deck::after(const std::vector<Card> &cards, const Card &card) {
-    int loc = find(cards,card);
-    assert(loc >= 0);
-    return cards[forward(cards,loc,1)];
-  }
-
-  const Card& Deck::before(const std::vector<Card> &cards,const Card &card) {
-    int loc = find(cards,card);
-    assert(loc >= 0);
-    int beforeLoc = back(cards,loc,1);
-    return cards[beforeLoc];
+  int Deck::padLoc(int zth, int offset) const {
+    int zthLoc = forward(cards,0,zth);
+    if (offset >= 0) {
+      Card markCard=addMod(cards[zthLoc],Card(offset));
+      int markLoc = find(markCard);
+      int padLoc = forward(cards,markLoc,1);
+      return padLoc;
+    } else {
+      return zthLoc;
+    }
   }
 
   Card Deck::addMod(const Card &a, const Card &b) const {
@@ -116,14 +80,9 @@ namespace spider {
     return spider::subMod(a,b,modulus());
   }
 
-  const DeckConfig& Deck::config() {
-    auto recalled = retain<const DeckConfig>::begin();
-    return (recalled != retain<const DeckConfig>::end()) ? *recalled : DeckConfig::DEFAULT;
-  }
-
   Card Deck::cipherPad() const {
-    const DeckConfig &cfg=config();
-    int cipherPadLoc = padLoc(cards,cfg.cipherZth,cfg.cipherOffset,modulus());
+    const DeckConfig &cfg=boundConfig();
+    int cipherPadLoc = padLoc(cfg.cipherZth,cfg.cipherOffset);
     return cards[cipherPadLoc];
   }
   
@@ -161,8 +120,8 @@ namespace spider {
     //return cards[forward(cards,find(cards,addMod(cards[forward(cards,0,2)],Card(modulus()-2))),1)]; // trials=1e6 z2(xy)=8.14
     //return cards[forward(cards,find(cards,addMod(cards[forward(cards,0,2)],Card(modulus()-10))),1)]; // trials=1e6 z2(xy)=8.8
     //return cards[forward(cards,find(cards,addMod(cards[forward(cards,0,2)],Card(1))),1)]; // trials=1e6 z2(xy)=469    
-    const DeckConfig &cfg=config();
-    int cutPadLoc = padLoc(cards,cfg.cutZth,cfg.cutOffset,modulus());
+    const DeckConfig &cfg=boundConfig();
+    int cutPadLoc = padLoc(cfg.cutZth,cfg.cutOffset);
     return cards[cutPadLoc];
   }
 
@@ -173,9 +132,9 @@ namespace spider {
 
 
   void Deck::unmix(const Card &plainCard) {
-    std::vector<Card> temp(cards.size());
+    Cards temp(cards.size());
     backFrontUnshuffle(cards,temp);
-    const DeckConfig &cfg=config();
+    const DeckConfig &cfg=boundConfig();
 
     Card cutCard = temp[0];
     Card cutPad = subMod(cutCard,plainCard);
@@ -192,60 +151,79 @@ namespace spider {
     int topLoc = back(temp,zthLoc,cfg.cutZth);
 
     cut(temp,topLoc,cards);
+    if (indexed) index();
   }
 
 
-  void Deck::cut(const std::vector<Card> &in, int cutLoc, std::vector<Card> &out) {
-    out.resize(in.size());
-    // copy bottom of deck (starting from cutLoc) to top of deck
-    std::copy(std::begin(in)+(cutLoc),std::end(in),std::begin(out));
-    // copy top of deck (up to but excluding cut card) to bottom of deck
-    std::copy(std::begin(in), std::begin(in)+(cutLoc),
-	      std::end(out)-(cutLoc));
+  namespace {
+    struct BackFrontSources {
+      uint8_t source[Deck::MAX_SIZE+1][Deck::MAX_SIZE];
+      BackFrontSources() {
+	for (unsigned n=1; n<=Deck::MAX_SIZE; ++n) {
+	  unsigned back = n/2;
+	  unsigned front = back-1;
+	  for (unsigned i=0; i<n; ++i) {
+	    if (i % 2 == 0) {
+	      source[n][back]=i;
+	      ++back;
+	    } else {
+	      source[n][front]=i;
+	      --front;
+	    }
+	  }
+	}
+      }
+    };
+  }
 
+  const uint8_t* Deck::backFrontSource(unsigned n) {
+    static const BackFrontSources tables;
+    assert(0 < n && n <= MAX_SIZE);
+    return tables.source[n];
   }
-  
-  void Deck::backFrontShuffle(const std::vector<Card> &in, std::vector<Card> &out) {
-    out.resize(in.size());
-    size_t back = in.size()/2;
-    size_t front = back-1;
-    for (size_t i=0; i<in.size(); ++i) {
-      if (i % 2 == 0) {
-	out[back]=in[i];
-	++back;
-      } else {
-	out[front]=in[i];
-	--front;
+
+  namespace {
+    // N > 0 fixes the deck size at compile time, N == 0 uses n.
+    template <unsigned N, bool INDEX>
+    inline void gatherCutBackFront(Card *cards, unsigned n, unsigned cutLoc, uint8_t *locs) {
+      if (N > 0) n = N;
+      // two copies back to back, so the cut is just an offset: cut(in)[i]
+      // is twice[cutLoc+i] with no modulus in the loop.
+      uint8_t twice[2*Deck::MAX_SIZE];
+      for (unsigned i=0; i<n; ++i) {
+	twice[i]=twice[n+i]=cards[i].order;
+      }
+      const uint8_t *source = Deck::backFrontSource(n);
+      const uint8_t *top = twice + cutLoc;
+      for (unsigned i=0; i<n; ++i) {
+	uint8_t card = top[source[i]];
+	cards[i].order=card;
+	if (INDEX) locs[card]=i;
       }
     }
-  }
-  
-  void Deck::backFrontUnshuffle(const std::vector<Card> &in, std::vector<Card> &out) {
-    out.resize(in.size());
-    int back = in.size();
-    int front = -1;
-    for (int i=in.size()-1; i >= 0; --i) {
-      if (i % 2 == 0) {
-	--back;
-	out[i]=in[back];
 
+    template <unsigned N>
+    inline void gatherCutBackFront(Card *cards, unsigned n, unsigned cutLoc, uint8_t *locs) {
+      if (locs != 0) {
+	gatherCutBackFront<N,true>(cards,n,cutLoc,locs);
       } else {
-	++front;
-	out[i]=in[front];
+	gatherCutBackFront<N,false>(cards,n,cutLoc,locs);
       }
     }
   }
 
-  void Deck::pseudoShuffle(const Card &cutCard) {
-    std::vector<Card> temp(cards.size());
+  void Deck::cutBackFrontShuffle(Card *cards, unsigned n, unsigned cutLoc, uint8_t *locs) {
+    switch (n) {
+    case 10: gatherCutBackFront<10>(cards,n,cutLoc,locs); break;
+    case 40: gatherCutBackFront<40>(cards,n,cutLoc,locs); break;
+    default: gatherCutBackFront<0>(cards,n,cutLoc,locs); break;
+    }
+  }
 
+  void Deck::pseudoShuffle(const Card &cutCard) {
     int cutLoc = find(cutCard);
     assert(cutLoc >= 0);
-    cut(cards,cutLoc,temp);
-    assert(temp[0] == cutCard);
-
-    backFrontShuffle(temp,cards);
-    int topLoc = forward(cards,0,0);
+    cutBackFrontShuffle(cards.data(),cards.size(),cutLoc,indexed ? locs : 0);
   }
 
   bool Deck::operator<(const Deck &deck) const {
@@ -0,0 +1,201 @@
+#include <string.h>
+#include <cassert>
+
+#include "deck_batch.h"
+
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+//
+// The kernels are written with gcc/clang vector extensions over
+// DeckBatch::Lanes, so each statement is one operation over all the
+// lanes.  On x86 they are also compiled for AVX2 and the best version
+// is picked when the program loads.
+//
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && defined(__linux__)
+#define BATCH_KERNEL __attribute__((target_clones("avx2","default")))
+#else
+#define BATCH_KERNEL
+#endif
+
+// The helpers pass Lanes by value, so they must be inlined into each
+// version of a kernel: the AVX2 and default versions pass vectors
+// differently.
+#define BATCH_INLINE inline __attribute__((always_inline))
+
+namespace spider {
+
+  typedef DeckBatch::Lanes Lanes;
+  static const int LANES = DeckBatch::LANES;
+
+  namespace {
+
+    BATCH_INLINE Lanes splat(int value) {
+      Lanes ans;
+      for (int lane=0; lane<LANES; ++lane) ans[lane]=value;
+      return ans;
+    }
+
+    BATCH_INLINE Lanes addMod(const Lanes &a, const Lanes &b, int modulus) {
+      Lanes sum = a + b;
+      return (sum >= (uint8_t) modulus) ? Lanes(sum - (uint8_t) modulus) : sum;
+    }
+
+    // Deck::forward(cards,0,zth) per lane, the card there.
+    BATCH_INLINE Lanes zthCards(const Lanes *cards, int n, int zth) {
+      if (n <= 40) return cards[zth % n];
+
+      // skip J,Q,K and jokers, counting the cipher cards seen
+      Lanes ans = splat(0), count = splat(0), found = splat(0);
+      Lanes target = splat(zth % 40);
+      for (int loc=0; loc<n; ++loc) {
+	Lanes card = cards[loc];
+	Lanes valid = (Lanes) (card < 40);
+	Lanes hit = valid & (Lanes) (count == target) & ~found;
+	ans = hit ? card : ans;
+	found |= hit;
+	count -= valid;
+      }
+      return ans;
+    }
+
+    // Deck::after(cards,mark) per lane.
+    BATCH_INLINE Lanes afterCards(const Lanes *cards, int n, const Lanes &mark) {
+      Lanes ans = splat(0);
+      if (n <= 40) {
+	for (int loc=0; loc<n; ++loc) {
+	  ans = (cards[loc] == mark) ? cards[loc+1 < n ? loc+1 : 0] : ans;
+	}
+	return ans;
+      }
+
+      // the first cipher card after the mark, going around at most twice
+      Lanes seen = splat(0), done = splat(0);
+      for (int pass=0; pass<2; ++pass) {
+	for (int loc=0; loc<n; ++loc) {
+	  Lanes card = cards[loc];
+	  Lanes take = seen & (Lanes) (card < 40) & ~done;
+	  ans = take ? card : ans;
+	  done |= take;
+	  seen |= (Lanes) (card == mark);
+	}
+      }
+      return ans;
+    }
+
+    // Deck::padLoc(cards,zth,offset,modulus) per lane, the card there.
+    BATCH_INLINE Lanes padCards(const Lanes *cards, int n, int zth, int offset, int modulus) {
+      Lanes zth_cards = zthCards(cards,n,zth);
+      if (offset < 0) return zth_cards;
+      return afterCards(cards,n,addMod(zth_cards,splat(offset % modulus),modulus));
+    }
+
+    // the fused cut and back-front shuffle of every lane, each lane
+    // cut at its own cut card.
+    BATCH_INLINE void pseudoShuffle(Lanes *cards, int n, const Lanes &cut) {
+      Lanes cutLoc = splat(0);
+      for (int loc=0; loc<n; ++loc) {
+	cutLoc = (cards[loc] == cut) ? splat(loc) : cutLoc;
+      }
+
+      // Cutting is a rotation by cutLoc, which differs per lane.  Rotate
+      // every lane by each power of two set in its cutLoc: log2(n) rounds
+      // of one blend per location.
+      Lanes rotated[2][Deck::MAX_SIZE];
+      const Lanes *in = cards;
+      Lanes *out = rotated[0];
+      for (int shift=1; shift<n; shift *= 2) {
+	Lanes rotate = (Lanes) ((cutLoc & (uint8_t) shift) != 0);
+	for (int loc=0; loc<n; ++loc) {
+	  int from = loc+shift < n ? loc+shift : loc+shift-n;
+	  out[loc] = rotate ? in[from] : in[loc];
+	}
+	in = out;
+	out = (out == rotated[0]) ? rotated[1] : rotated[0];
+      }
+
+      // the back-front shuffle moves whole locations, the same for every lane
+      const uint8_t *source = Deck::backFrontSource(n);
+      if (in == cards) {
+	memcpy(rotated[0],cards,n*sizeof(Lanes));
+	in = rotated[0];
+      }
+      for (int loc=0; loc<n; ++loc) {
+	cards[loc]=in[source[loc]];
+      }
+    }
+
+    BATCH_KERNEL
+    void batchPads(const Lanes *cards, int n, int zth, int offset, int modulus, uint8_t *pads) {
+      Lanes ans = padCards(cards,n,zth,offset,modulus);
+      memcpy(pads,&ans,sizeof(Lanes));
+    }
+
+    BATCH_KERNEL
+    void batchStep(Lanes *cards, int n, const DeckConfig &cfg, int modulus,
+		   const uint8_t *plains, uint8_t *cipherPads, uint8_t *cutPads) {
+      Lanes plain;
+      memcpy(&plain,plains,sizeof(Lanes));
+      Lanes cutPad = padCards(cards,n,cfg.cutZth,cfg.cutOffset,modulus);
+      pseudoShuffle(cards,n,addMod(cutPad,plain,modulus));
+      if (cipherPads != 0) {
+	Lanes ans = padCards(cards,n,cfg.cipherZth,cfg.cipherOffset,modulus);
+	memcpy(cipherPads,&ans,sizeof(Lanes));
+      }
+      if (cutPads != 0) {
+	Lanes ans = padCards(cards,n,cfg.cutZth,cfg.cutOffset,modulus);
+	memcpy(cutPads,&ans,sizeof(Lanes));
+      }
+    }
+  }
+
+  const int DeckBatch::LANES;
+
+  DeckBatch::DeckBatch(int _n) : n(_n), bound(false) {
+    assert(n > 0 && n <= (int) Deck::MAX_SIZE);
+    for (int loc=0; loc<n; ++loc) {
+      cards[loc]=splat(loc);
+    }
+  }
+
+  int DeckBatch::modulus() const { return n == 10 ? 10 : 40; }
+
+  void DeckBatch::set(int lane, const Deck &deck) {
+    assert(lane >= 0 && lane < LANES && (int) deck.cards.size() == n);
+    for (int loc=0; loc<n; ++loc) {
+      cards[loc][lane]=deck.cards[loc].order;
+    }
+  }
+
+  Deck DeckBatch::get(int lane) const {
+    assert(lane >= 0 && lane < LANES);
+    Deck deck(n);
+    for (int loc=0; loc<n; ++loc) {
+      deck.cards[loc]=Card(cards[loc][lane]);
+    }
+    return deck;
+  }
+
+  void DeckBatch::cipherPads(uint8_t pads[LANES]) const {
+    const DeckConfig &cfg = boundConfig();
+    batchPads(cards,n,cfg.cipherZth,cfg.cipherOffset,modulus(),pads);
+  }
+
+  void DeckBatch::cutPads(uint8_t pads[LANES]) const {
+    const DeckConfig &cfg = boundConfig();
+    batchPads(cards,n,cfg.cutZth,cfg.cutOffset,modulus(),pads);
+  }
+
+  void DeckBatch::mix(const uint8_t plains[LANES]) {
+    step(plains,0,0);
+  }
+
+  void DeckBatch::step(const uint8_t plains[LANES], uint8_t cipherPads[LANES], uint8_t cutPads[LANES]) {
+    // the kernels add modulo with a single subtract
+    uint8_t reduced[LANES];
+    int m = modulus();
+    for (int lane=0; lane<LANES; ++lane) {
+      reduced[lane] = plains[lane] % m;
+    }
+    batchStep(cards,n,boundConfig(),m,reduced,cipherPads,cutPads);
+  }
+}
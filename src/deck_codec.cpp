@@ -0,0 +1,315 @@
+#include <string.h>
+#include <cassert>
+
+#include "deck_codec.h"
+
+namespace spider {
+
+  namespace {
+
+    // The Lehmer digit of each card is the number of smaller cards
+    // after it: one popcount of the unseen cards below it, with all n
+    // cards as bits of one word, and back by selecting the digit-th
+    // unseen bit.  Both are branch free SWAR over the 8 bytes of the
+    // word (popcnt when the build has it).  The rank is the digits in the mixed
+    // radix n, n-1, ..., 1.  Runs of radixes whose product fits in 32
+    // bits are folded into one digit first, so the multi-word rank
+    // (LIMBS 32 bit limbs) sees about n/5 multiplies and divides
+    // instead of n.  N > 0 fixes the deck size at compile time.
+
+    const uint64_t ONES = 0x0101010101010101ULL;
+
+    // set bits in each byte of x
+    inline uint64_t byteCounts(uint64_t x) {
+      x = x - ((x >> 1) & 0x5555555555555555ULL);
+      x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+      return (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    }
+
+    inline int countBits(uint64_t x) {
+#ifdef __POPCNT__
+      return __builtin_popcountll(x);
+#else
+      return (byteCounts(x) * ONES) >> 56;
+#endif
+    }
+
+    // kth[b][k]: the k-th set bit of byte b
+    struct SelectTable {
+      uint8_t kth[256][8];
+      constexpr SelectTable() : kth() {
+	for (int b=0; b<256; ++b) {
+	  int k = 0;
+	  for (int bit=0; bit<8; ++bit) {
+	    if (b & (1 << bit)) kth[b][k++] = bit;
+	  }
+	}
+      }
+    };
+    constexpr SelectTable SELECT;
+
+    // the k-th (from 0) set bit of x, without a loop: the running
+    // byte counts pick the byte, the table the bit within it
+    inline int selectBit(uint64_t x, unsigned k) {
+      uint64_t before = byteCounts(x) * ONES;
+      // bytes whose running count is <= k (all counts are <= 64)
+      uint64_t low = ((k*ONES | 0x8080808080808080ULL) - before) & 0x8080808080808080ULL;
+      unsigned byte = ((low >> 7) * ONES) >> 56;
+      unsigned skip = ((before << 8) >> (8*byte)) & 0xff;
+      return 8*byte + SELECT.kth[(x >> (8*byte)) & 0xff][k-skip];
+    }
+
+    // FASTDIV.m[k] = 2^64/k rounded up: ((m*x) >> 64) is x/k for any
+    // 32 bit x (Lemire's fastdiv), with no divide instruction
+    struct FastDiv {
+      uint64_t m[Deck::MAX_SIZE+1];
+      constexpr FastDiv() : m() {
+	for (unsigned k=2; k<=Deck::MAX_SIZE; ++k) m[k] = ~0ULL/k + 1;
+      }
+    };
+    constexpr FastDiv FASTDIV;
+
+    inline uint64_t mulHigh(uint64_t a, uint64_t b) {
+      return (unsigned __int128)(a)*b >> 64;
+    }
+
+    // the end of the radix run starting at card i, and its product
+    inline int radixRun(int n, int i, uint64_t &product) {
+      product = 1;
+      while (i < n && product*uint64_t(n-i) < (1ULL << 32)) {
+	product *= n-i;
+	++i;
+      }
+      return i;
+    }
+
+    template <int N, int LIMBS>
+    inline void rankCards(const uint8_t *cards, int n, uint32_t *rank) {
+      if (N > 0) n = N;
+      uint64_t unseen = (1ULL << n) - 1;
+      for (int l=0; l<LIMBS; ++l) rank[l] = 0;
+      for (int i=0; i<n; ) {
+	uint64_t product;
+	int end = radixRun(n,i,product);
+	uint64_t digit = 0;
+	for (; i<end; ++i) {
+	  uint64_t bit = 1ULL << cards[i];
+	  digit = digit*(n-i) + countBits(unseen & (bit-1));
+	  unseen &= ~bit;
+	}
+	uint64_t carry = digit;
+	for (int l=0; l<LIMBS; ++l) {
+	  uint64_t t = uint64_t(rank[l])*product + carry;
+	  rank[l] = uint32_t(t);
+	  carry = t >> 32;
+	}
+      }
+    }
+
+    template <int N, int LIMBS>
+    inline void unrankCards(const uint32_t *rank, int n, uint8_t *cards) {
+      if (N > 0) n = N;
+      uint32_t r[LIMBS];
+      for (int l=0; l<LIMBS; ++l) r[l] = rank[l];
+
+      int starts[Deck::MAX_SIZE+1];
+      int runs = 0;
+      for (int i=0; i<n; ) {
+	uint64_t product;
+	starts[runs++] = i;
+	i = radixRun(n,i,product);
+      }
+      starts[runs] = n;
+
+      uint8_t digits[Deck::MAX_SIZE];
+      for (int run=runs-1; run>=0; --run) {
+	uint64_t product;
+	radixRun(n,starts[run],product);
+	// one divide for the reciprocal, whose quotients are at most
+	// 2 short, instead of one per limb
+	uint64_t inverse = ~0ULL/product;
+	uint64_t rem = 0;
+	for (int l=LIMBS-1; l>=0; --l) {
+	  uint64_t t = (rem << 32) | r[l];
+	  uint64_t q = mulHigh(t,inverse);
+	  rem = t - q*product;
+	  while (rem >= product) {
+	    rem -= product;
+	    ++q;
+	  }
+	  r[l] = uint32_t(q);
+	}
+	uint32_t digit = rem;
+	for (int i=starts[run+1]-1; i>=starts[run]; --i) {
+	  int radix = n-i;
+	  if (radix == 1) {
+	    digits[i] = 0;
+	    continue;
+	  }
+	  uint32_t q = mulHigh(FASTDIV.m[radix],digit);
+	  digits[i] = digit - q*radix;
+	  digit = q;
+	}
+      }
+
+      uint64_t unseen = (1ULL << n) - 1;
+      for (int i=0; i<n; ++i) {
+	// the digits[i]-th smallest unseen card
+	int card = selectBit(unseen,digits[i]);
+	cards[i] = card;
+	unseen &= ~(1ULL << card);
+      }
+    }
+
+    template <int LIMBS>
+    inline void rankAny(const uint8_t *cards, int n, uint32_t *rank) {
+      switch (n) {
+      case 10: rankCards<10,LIMBS>(cards,n,rank); break;
+      case 40: rankCards<40,LIMBS>(cards,n,rank); break;
+      default: rankCards<0,LIMBS>(cards,n,rank); break;
+      }
+    }
+
+    template <int LIMBS>
+    inline void unrankAny(const uint32_t *rank, int n, uint8_t *cards) {
+      switch (n) {
+      case 10: unrankCards<10,LIMBS>(rank,n,cards); break;
+      case 40: unrankCards<40,LIMBS>(rank,n,cards); break;
+      default: unrankCards<0,LIMBS>(rank,n,cards); break;
+      }
+    }
+
+    // 4 cards to 3 bytes; N > 0 fixes the deck size
+    template <int N>
+    inline void packCards(const uint8_t *cards, int n, uint8_t *key, size_t bytes) {
+      if (N > 0) n = N;
+      memset(key,0,bytes);
+      int i = 0, at = 0;
+      for (; i+4 <= n; i += 4, at += 3) {
+	uint32_t word = cards[i] | (cards[i+1] << 6) | (cards[i+2] << 12) | (uint32_t(cards[i+3]) << 18);
+	key[at] = word;
+	key[at+1] = word >> 8;
+	key[at+2] = word >> 16;
+      }
+      for (; (N == 0 || N % 4 != 0) && i<n; ++i) {
+	unsigned bit = 6*i;
+	key[bit/8] |= cards[i] << (bit%8);
+	if (bit%8 > 2) key[bit/8+1] |= cards[i] >> (8-bit%8);
+      }
+    }
+
+    template <int N>
+    inline void unpackCards(const uint8_t *key, int n, uint8_t *cards) {
+      if (N > 0) n = N;
+      int i = 0, at = 0;
+      for (; i+4 <= n; i += 4, at += 3) {
+	uint32_t word = key[at] | (key[at+1] << 8) | (uint32_t(key[at+2]) << 16);
+	cards[i] = word & 63;
+	cards[i+1] = (word >> 6) & 63;
+	cards[i+2] = (word >> 12) & 63;
+	cards[i+3] = (word >> 18) & 63;
+      }
+      for (; (N == 0 || N % 4 != 0) && i<n; ++i) {
+	unsigned bit = 6*i;
+	unsigned word = key[bit/8] | ((bit%8 > 2) ? unsigned(key[bit/8+1]) << 8 : 0);
+	cards[i] = (word >> (bit%8)) & 63;
+      }
+    }
+  }
+
+  const size_t DeckCodec::MAX_BYTES;
+
+  DeckCodec::DeckCodec(int _n, Format _format, bool _rotate) : n(_n), format(_format), rotate(_rotate) {
+    assert(0 < n && n <= int(Deck::MAX_SIZE));
+    if (format == PACKED) {
+      m_bytes = (6*n+7)/8;
+      m_limbs = 0;
+      return;
+    }
+
+    // the bits of n!-1
+    uint32_t fact[8] = {1,0,0,0,0,0,0,0};
+    for (int k=2; k<=n; ++k) {
+      uint64_t carry = 0;
+      for (int l=0; l<8; ++l) {
+	uint64_t t = uint64_t(fact[l])*k + carry;
+	fact[l] = uint32_t(t);
+	carry = t >> 32;
+      }
+    }
+    for (int l=0; l<8; ++l) {
+      if (fact[l]-- != 0) break;
+    }
+    int bits = 0;
+    for (int l=7; l>=0; --l) {
+      if (fact[l] != 0) {
+	bits = 32*l + 32 - __builtin_clz(fact[l]);
+	break;
+      }
+    }
+    m_bytes = bits > 0 ? (bits+7)/8 : 1;
+    m_limbs = bits > 0 ? (bits+31)/32 : 1;
+  }
+
+  int DeckCodec::rotation(const Deck &deck) {
+    return Deck::forward(deck.cards,0,0);
+  }
+
+  int DeckCodec::encode(const Deck &deck, uint8_t *key) const {
+    assert(int(deck.cards.size()) == n);
+    int top = (!rotate || n <= 40) ? 0 : rotation(deck);
+    uint8_t cards[Deck::MAX_SIZE];
+    if (top == 0) {
+      memcpy(cards,deck.cards.data(),n);
+    } else {
+      memcpy(cards,deck.cards.data()+top,n-top);
+      memcpy(cards+n-top,deck.cards.data(),top);
+    }
+
+    if (format == PACKED) {
+      switch (n) {
+      case 10: packCards<10>(cards,n,key,m_bytes); break;
+      case 40: packCards<40>(cards,n,key,m_bytes); break;
+      default: packCards<0>(cards,n,key,m_bytes); break;
+      }
+      return top;
+    }
+
+    uint32_t rank[8];
+    switch (m_limbs) {
+    case 1: rankAny<1>(cards,n,rank); break;
+    case 5: rankAny<5>(cards,n,rank); break;
+    case 8: rankAny<8>(cards,n,rank); break;
+    default: rankAny<8>(cards,n,rank); break;
+    }
+    // little endian limbs are little endian bytes
+    memcpy(key,rank,m_bytes);
+    return top;
+  }
+
+  Deck DeckCodec::decode(const uint8_t *key, int top) const {
+    uint8_t cards[Deck::MAX_SIZE];
+    if (format == PACKED) {
+      switch (n) {
+      case 10: unpackCards<10>(key,n,cards); break;
+      case 40: unpackCards<40>(key,n,cards); break;
+      default: unpackCards<0>(key,n,cards); break;
+      }
+    } else {
+      uint32_t rank[8] = {0,0,0,0,0,0,0,0};
+      memcpy(rank,key,m_bytes);
+      switch (m_limbs) {
+      case 1: unrankAny<1>(rank,n,cards); break;
+      case 5: unrankAny<5>(rank,n,cards); break;
+      default: unrankAny<8>(rank,n,cards); break;
+      }
+    }
+
+    Deck ans(n);
+    for (int i=0; i<n; ++i) {
+      int at = i+top < n ? i+top : i+top-n;
+      ans.cards[at] = Card(cards[i]);
+    }
+    return ans;
+  }
+}
@@ -0,0 +1,84 @@
+#include <utility>
+#include <cassert>
+
+#include "deck_kernel.h"
+
+namespace spider {
+
+  namespace {
+
+    // Deck::padLoc(zth,offset) for an N card deck, all fixed
+    template <unsigned N, int ZTH, int OFFSET>
+    Card compiledPad(const Deck &deck, int, int) {
+      static const unsigned M = (N == 10) ? 10 : 40;
+      const Card *cards = deck.cards.data();
+
+      // with no J,Q,K or jokers forward() is just a location
+      unsigned zthLoc = (N <= 40) ? ZTH % N : Deck::forward(deck.cards,0,ZTH);
+      if (OFFSET < 0) return cards[zthLoc];
+
+      unsigned mark = cards[zthLoc].order + OFFSET % M;
+      if (mark >= M) mark -= M;
+      unsigned markLoc = deck.indexed ? deck.locs[mark] : Deck::find(deck.cards,Card(mark));
+      if (N <= 40) return cards[markLoc+1 < N ? markLoc+1 : 0];
+      return cards[Deck::forward(deck.cards,markLoc+1 < N ? markLoc+1 : 0,0)];
+    }
+
+    static const unsigned SIZES[] = {10, 40, 52, 54};
+    static const int ZTHS = 6;
+    static const int OFFSETS = 41;  // -1..39
+
+    typedef std::integer_sequence<int,0,1,2,3,4,5> CompiledZths;
+    typedef std::integer_sequence<int,-1,0,1,2,3,4,5,35,36,37,38,39> CompiledOffsets;
+
+    struct CompiledPads {
+      DeckKernel::Pad pads[4][ZTHS][OFFSETS];
+
+      template <unsigned N, int ZTH, int... OFFSET>
+      void add(int size, std::integer_sequence<int,OFFSET...>) {
+	((pads[size][ZTH][OFFSET+1] = &compiledPad<N,ZTH,OFFSET>), ...);
+      }
+
+      template <unsigned N, int... ZTH>
+      void add(int size, std::integer_sequence<int,ZTH...>) {
+	(add<N,ZTH>(size,CompiledOffsets()), ...);
+      }
+
+      CompiledPads() {
+	for (auto &size : pads) for (auto &zth : size) for (auto &pad : zth) pad = 0;
+	add<10>(0,CompiledZths());
+	add<40>(1,CompiledZths());
+	add<52>(2,CompiledZths());
+	add<54>(3,CompiledZths());
+      }
+
+      DeckKernel::Pad find(unsigned n, int zth, int offset) const {
+	if (zth < 0 || zth >= ZTHS || offset < -1 || offset >= OFFSETS-1) return 0;
+	for (int size=0; size<4; ++size) {
+	  if (SIZES[size] == n) return pads[size][zth][offset+1];
+	}
+	return 0;
+      }
+    };
+  }
+
+  Card DeckKernel::generic(const Deck &deck, int zth, int offset) {
+    return deck.cards[deck.padLoc(zth,offset)];
+  }
+
+  DeckKernel::Pad DeckKernel::pad(unsigned n, int zth, int offset) {
+    static const CompiledPads compiled;
+    Pad ans = compiled.find(n,zth,offset);
+    return ans != 0 ? ans : &generic;
+  }
+
+  DeckKernel::DeckKernel(unsigned _n, const DeckConfig &_cfg)
+    : n(_n), cfg(_cfg), cipher(pad(n,cfg.cipherZth,cfg.cipherOffset)), cut(pad(n,cfg.cutZth,cfg.cutOffset))
+  {
+    assert(0 < n && n <= Deck::MAX_SIZE);
+  }
+
+  bool DeckKernel::specialized() const {
+    return cipher != &generic && cut != &generic;
+  }
+}
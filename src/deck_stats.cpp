@@ -0,0 +1,338 @@
+#include <math.h>
+#include <string.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include "deck_stats.h"
+#include "deck_batch.h"
+#include "deck_kernel.h"
+#include "histogram.h"
+
+namespace spider {
+
+  std::vector<DeckConfig> top40Configs() {
+    std::vector<DeckConfig> cfgs;
+    { DeckConfig cfg; cfg.cipherZth = 5; cfg.cipherOffset = 35; cfg.cutZth = 1; cfg.cutOffset = 38; cfgs.push_back(cfg); }
+    return cfgs;
+  }
+
+  std::vector<DeckConfig> configs() {
+    std::vector<DeckConfig> cfgs;
+    DeckConfig cfg;  
+    for (auto cipherZth : {0,1,2,3,4,5}) {
+      cfg.cipherZth = cipherZth;
+      for (auto cipherOffset : {1,2,3,4,5,35,36,37,38,39}) {
+        cfg.cipherOffset=cipherOffset;
+        for (auto cutZth : {0,1,2,3,4,5}) {
+	  if (cutZth == cipherZth) continue;
+	  cfg.cutZth = cutZth;
+	  for (auto cutOffset : {-1,1,2,3,4,5,35,36,37,38,39}) {
+	    cfg.cutOffset=cutOffset;
+	    cfgs.push_back(cfg);
+	  }
+        }
+      }
+    }
+    return cfgs;
+  }
+
+  std::vector<DeckConfig> configsCutEasy() {
+    std::vector<DeckConfig> cfgs;
+    DeckConfig cfg;  
+    for (auto cipherZth : {0,1,2}) {
+      cfg.cipherZth = cipherZth;
+      for (auto cipherOffset : {1,2,3,37,38,39}) {
+        cfg.cipherOffset=cipherOffset;
+        for (auto cutZth : {0,1,2}) {
+	  if (cutZth == cipherZth) continue;
+	  cfg.cutZth = cutZth;
+	  for (auto cutOffset : {-1}) {
+	    cfg.cutOffset=cutOffset;
+	    cfgs.push_back(cfg);
+	  }
+        }
+      }
+    }
+    return cfgs;
+  }
+
+  std::vector<DeckConfig> configsCutEasy2() {
+    std::vector<DeckConfig> cfgs;
+    DeckConfig cfg;  
+    for (auto cipherZth : {0,2}) {
+      cfg.cipherZth = cipherZth;
+      for (auto cipherOffset : {1,2,3,37,38,39}) {
+        cfg.cipherOffset=cipherOffset;
+        for (auto cutZth : {0,2}) {
+	  if (cutZth == cipherZth) continue;
+	  cfg.cutZth = cutZth;
+	  for (auto cutOffset : {-1}) {
+	    cfg.cutOffset=cutOffset;
+	    cfgs.push_back(cfg);
+	  }
+        }
+      }
+    }
+    return cfgs;
+  }
+
+  namespace {
+
+    // each z-trial draws from its own stream: one seed, jumped once per z
+    typedef XOSHIRO_RNG StreamRNG;
+
+    // the histograms of one z-trial, reset in place between z-trials
+    struct DeckTables {
+      Histogram ciphers;
+      Histogram ciphers2;
+      Histogram cuts;
+      Histogram cuts2;
+      Histogram xy;
+
+      DeckTables(int n) : ciphers(n), ciphers2(n,2), cuts(n), cuts2(n,2), xy(n,2) {}
+
+      void reset() {
+        ciphers.reset();
+        ciphers2.reset();
+        cuts.reset();
+        cuts2.reset();
+        xy.reset();
+      }
+
+      void add(int cipher, int cut) {
+        ciphers.add(cipher);
+        ciphers2.push(cipher);
+        cuts.add(cut);
+        cuts2.push(cut);
+        xy.add(xy.cell(cut,cipher));
+      }
+
+      ZLuck luck() const {
+        ZLuck ans;
+        ans.cipher = ciphers.z();
+        ans.cipher2 = ciphers2.z();
+        ans.cut = cuts.z();
+        ans.cut2 = cuts2.z();
+        ans.xy = xy.z();
+        return ans;
+      }
+    };
+
+    //
+    // The deck and histograms for running z-trials, one per worker
+    // thread.  A z-trial only depends on its rng stream, so the serial
+    // and the batch runs of the same streams give the same lucks.
+    //
+    struct DeckTrials {
+      int n;
+      int tTrials;
+      int messageLen;
+
+      Deck deck;
+      DeckKernel kernel;
+      DeckTables tables;
+      std::vector< DeckTables > laneTables;
+
+      DeckTrials(int _n, int _tTrials, int _messageLen, const DeckConfig &cfg) : n(_n), tTrials(_tTrials), messageLen(_messageLen), deck(n), kernel(n,cfg), tables(n) {}
+
+      template <typename Generator>
+      void tTrial(int t, Generator &rng) {
+        if (t == 0) {
+          tables.reset();
+          deck = Deck(n);
+          deck.index();
+          deck.shuffle(rng);
+        }
+
+        if (messageLen > 0 && t % messageLen == 0) {
+          for (int i=0; i<10; ++i) {
+	    kernel.mix(deck,rng.next(0,deck.modulus()-1));
+          }
+        }
+
+        static const std::string testMessage = "SPIDER SOLITAIRE ";
+        int offset = (messageLen > 0) ? (t % messageLen) : t;
+        kernel.mix(deck,rng.next(0,deck.modulus()-1));
+        kernel.mix(deck,Card(testMessage[offset % testMessage.length()]-'A'));
+
+        tables.add(kernel.cipherPad(deck).order,kernel.cutPad(deck).order);
+      }
+
+      template <typename Generator>
+      ZLuck zTrial(Generator &rng) {
+        for (int t=0; t<tTrials; ++t) {
+          tTrial(t,rng);
+        }
+        return tables.luck();
+      }
+
+      // lanes z-trials as the lanes of one DeckBatch, each lane drawing
+      // from its own stream and filling its own histograms from the per
+      // lane pads.
+      void zBatch(StreamRNG *rngs, int lanes, ZLuck *lucks) {
+        static const std::string testMessage = "SPIDER SOLITAIRE ";
+        static const int LANES = DeckBatch::LANES;
+        if (laneTables.empty()) {
+          laneTables.assign(LANES,DeckTables(n));
+        }
+
+        DeckBatch decks(n);
+        decks.bind(&kernel.cfg);
+        for (int lane=0; lane<lanes; ++lane) {
+          Deck deck(n);
+          deck.shuffle(rngs[lane]);
+          decks.set(lane,deck);
+          laneTables[lane].reset();
+        }
+        int m = decks.modulus();
+
+        uint8_t plains[LANES] = {0}, cipherPads[LANES], cutPads[LANES];
+        for (int t=0; t<tTrials; ++t) {
+          if (messageLen > 0 && t % messageLen == 0) {
+	    for (int i=0; i<10; ++i) {
+	      for (int lane=0; lane<lanes; ++lane) plains[lane]=rngs[lane].next(0,m-1);
+	      decks.mix(plains);
+	    }
+          }
+          int offset = (messageLen > 0) ? (t % messageLen) : t;
+          for (int lane=0; lane<lanes; ++lane) plains[lane]=rngs[lane].next(0,m-1);
+          decks.mix(plains);
+          for (int lane=0; lane<lanes; ++lane) plains[lane]=testMessage[offset % testMessage.length()]-'A';
+          decks.step(plains,cipherPads,cutPads);
+
+          for (int lane=0; lane<lanes; ++lane) {
+	    laneTables[lane].add(cipherPads[lane],cutPads[lane]);
+          }
+        }
+
+        for (int lane=0; lane<lanes; ++lane) {
+          lucks[lane]=laneTables[lane].luck();
+        }
+      }
+    };
+  }
+
+  DeckStats::DeckStats(int _n, RNG &_rng, std::ostream &_out) : n(_n), rng(_rng), out(_out), zTrials(10*10), tTrials(100*100), messageLen(-1), id(0), cfg(Deck::config()), progress(false), batch(false), threads(std::max(1u,std::thread::hardware_concurrency())), sprtAlpha(0), sprtDelta(1.0), zUsed(0) {}
+
+  void DeckStats::outHeader() {
+    out << "n,cipherZth,cipherOffset,cutZth,cutOffset,cipherMean,cipherSd,cipher2Mean,cipher2Sd,cutMean,cutSd,cut2Mean,cut2Sd,xyMean,xySd,zUsed" <<  std::endl;
+  }
+
+  void DeckStats::outRow() {
+    //    const DeckConfig &cfg = deck.config();
+    out << n << "," << cfg.cipherZth << "," << cfg.cipherOffset << "," << cfg.cutZth << "," << cfg.cutOffset << "," << zCipherStats.mean() <<  "," << zCipherStats.sd() << "," << zCipher2Stats.mean() << "," << zCipher2Stats.sd() << "," << zCutStats.mean() << "," << zCutStats.sd() << "," << zCut2Stats.mean() << "," << zCut2Stats.sd() << "," << zXyStats.mean() << "," << zXyStats.sd() << "," << zUsed << std::endl;
+  }
+
+  void DeckStats::zAdd(int z, const ZLuck &luck) {
+    if (z == 0) {
+      zCipherStats.reset();
+      zCipher2Stats.reset();
+      zCutStats.reset();
+      zCut2Stats.reset();
+      zXyStats.reset();
+    }
+    
+    zCipherStats.add(luck.cipher);
+    zCipher2Stats.add(luck.cipher2);
+    zCutStats.add(luck.cut);
+    zCut2Stats.add(luck.cut2);
+    zXyStats.add(luck.xy);
+
+    if (progress) {
+      if (floor(100*double(z)/double(zTrials)) != floor(100*double(z-1)/double(zTrials))) {
+	out << "at z=" << z << " out of " << zTrials << ":" << std::endl;
+	outHeader();
+	outRow();
+      }
+    }
+  }
+
+  bool DeckStats::rejects() const {
+    if (sprtAlpha <= 0) return false;
+
+    // log likelihood ratio of k unit normal zs with sum s, mean delta
+    // against mean 0, against Wald's bound; the alpha is shared by the
+    // five stats (Bonferroni).
+    double bound = log(5/sprtAlpha);
+    for (const Stats *stats : {&zCipherStats,&zCipher2Stats,&zCutStats,&zCut2Stats,&zXyStats}) {
+      double llr = sprtDelta*stats->sum - stats->total*sprtDelta*sprtDelta/2;
+      if (llr >= bound) return true;
+    }
+    return false;
+  }
+
+  void DeckStats::run() {
+    StreamRNG stream((uint64_t(rng.next_u32()) << 32) | rng.next_u32());
+    std::vector< StreamRNG > streams;
+    for (int z=0; z<zTrials; ++z) {
+      streams.push_back(stream);
+      stream.jump();
+    }
+
+    std::vector< ZLuck > lucks(zTrials);
+    std::vector< char > done(zTrials,0);
+    std::mutex mutex;
+    std::condition_variable ready;
+    int next = 0;
+    int limit = zTrials;
+    int chunk = batch ? DeckBatch::LANES : 1;
+
+    auto work = [&]() {
+      DeckTrials trials(n,tTrials,messageLen,cfg);
+      for (;;) {
+	int z0, lanes;
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  z0 = next;
+	  if (z0 >= limit) break;
+	  lanes = std::min(chunk,limit-z0);
+	  next += lanes;
+	}
+	std::vector< StreamRNG > rngs(streams.begin()+z0,streams.begin()+z0+lanes);
+	if (batch) {
+	  trials.zBatch(&rngs[0],lanes,&lucks[z0]);
+	} else {
+	  lucks[z0]=trials.zTrial(rngs[0]);
+	}
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  for (int z=z0; z<z0+lanes; ++z) done[z]=1;
+	}
+	ready.notify_all();
+      }
+    };
+
+    std::vector< std::thread > workers;
+    for (int i=0; i<std::max(threads,1); ++i) {
+      workers.push_back(std::thread(work));
+    }
+    zUsed = 0;
+    for (int z=0; z<zTrials; ++z) {
+      {
+	std::unique_lock<std::mutex> lock(mutex);
+	ready.wait(lock,[&]() { return done[z] != 0; });
+      }
+      zAdd(z,lucks[z]);
+      zUsed = z+1;
+      if (rejects()) {
+	std::lock_guard<std::mutex> lock(mutex);
+	limit = 0;
+	break;
+      }
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  void DeckStats::row() {
+    run();
+    if (id == 0) {
+      outHeader();
+    }
+    outRow();
+    ++id;
+  }
+}
@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <cassert>
+#include <new>
+#include <utility>
+
+#include "histogram.h"
+
+namespace spider {
+
+  static const size_t CACHE_LINE = 64;
+
+  static uint32_t* allocCounts(size_t cells) {
+    size_t bytes = (cells*sizeof(uint32_t)+CACHE_LINE-1)/CACHE_LINE*CACHE_LINE;
+    void *counts = aligned_alloc(CACHE_LINE,bytes);
+    if (counts == 0) throw std::bad_alloc();
+    return (uint32_t*) counts;
+  }
+
+  Histogram::Histogram(int bins, int dims, int lag, int every)
+    : m_bins(bins), m_dims(dims), m_lag(lag), m_every(every), m_cells(1),
+      m_total(0), m_squares(0), m_history((dims-1)*lag+1,0), m_span((dims-1)*lag+1),
+      m_head(0), m_seen(0), m_skip(0) {
+    assert(bins > 0 && dims > 0 && lag > 0 && every > 0);
+    for (int d=0; d<dims; ++d) {
+      m_cells *= bins;
+    }
+    m_counts = allocCounts(m_cells);
+    memset(m_counts,0,m_cells*sizeof(uint32_t));
+  }
+
+  Histogram::Histogram(const Histogram &copy)
+    : m_bins(copy.m_bins), m_dims(copy.m_dims), m_lag(copy.m_lag), m_every(copy.m_every),
+      m_cells(copy.m_cells), m_counts(allocCounts(copy.m_cells)), m_total(copy.m_total),
+      m_squares(copy.m_squares), m_history(copy.m_history), m_span(copy.m_span),
+      m_head(copy.m_head), m_seen(copy.m_seen), m_skip(copy.m_skip) {
+    memcpy(m_counts,copy.m_counts,m_cells*sizeof(uint32_t));
+  }
+
+  Histogram::Histogram(Histogram &&move)
+    : m_bins(move.m_bins), m_dims(move.m_dims), m_lag(move.m_lag), m_every(move.m_every),
+      m_cells(move.m_cells), m_counts(move.m_counts), m_total(move.m_total),
+      m_squares(move.m_squares), m_history(std::move(move.m_history)), m_span(move.m_span),
+      m_head(move.m_head), m_seen(move.m_seen), m_skip(move.m_skip) {
+    move.m_counts = 0;
+    move.m_cells = 0;
+  }
+
+  Histogram& Histogram::operator=(const Histogram &copy) {
+    if (this != &copy) {
+      Histogram tmp(copy);
+      *this = std::move(tmp);
+    }
+    return *this;
+  }
+
+  Histogram& Histogram::operator=(Histogram &&move) {
+    if (this != &move) {
+      free(m_counts);
+      m_bins = move.m_bins;
+      m_dims = move.m_dims;
+      m_lag = move.m_lag;
+      m_every = move.m_every;
+      m_cells = move.m_cells;
+      m_counts = move.m_counts;
+      m_total = move.m_total;
+      m_squares = move.m_squares;
+      m_history = std::move(move.m_history);
+      m_span = move.m_span;
+      m_head = move.m_head;
+      m_seen = move.m_seen;
+      m_skip = move.m_skip;
+      move.m_counts = 0;
+      move.m_cells = 0;
+    }
+    return *this;
+  }
+
+  Histogram::~Histogram() {
+    free(m_counts);
+  }
+
+  void Histogram::reset() {
+    memset(m_counts,0,m_cells*sizeof(uint32_t));
+    m_total = 0;
+    m_squares = 0;
+    m_head = 0;
+    m_seen = 0;
+    m_skip = 0;
+  }
+
+  double Histogram::chi2() const {
+    if (m_total == 0) return 0.0;
+    double mu = double(m_total)/double(m_cells);
+    return double(m_squares)/mu - double(m_total);
+  }
+
+  double Histogram::z() const {
+    return sqrt(2.0)*(sqrt(chi2())-sqrt(double(m_cells)-1.5));
+  }
+
+  uint64_t Histogram::squares() const {
+    uint64_t sum = 0;
+    for (size_t i=0; i<m_cells; ++i) {
+      sum += uint64_t(m_counts[i])*m_counts[i];
+    }
+    return sum;
+  }
+}
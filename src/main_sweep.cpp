@@ -0,0 +1,141 @@
+#include <stdlib.h>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "sweep.h"
+
+using namespace std;
+using namespace spider;
+
+//
+// bin/sweep: DeckStats rows over a space of DeckConfigs, resumable and
+// sharded.  Run shard i of k in k processes (or machines); rerun the
+// same command after a crash and only the missing rows are computed.
+// Each shard's csv starts with a "# " settings line and the header, so
+// merge them keeping the first file whole and the rows of the others:
+//
+//   (cat sweep-0-of-k.csv; for f in sweep-[1-9]*-of-k.csv; do tail -n +3 $f; done) > sweep.csv
+//
+void usage() {
+  cerr << "usage: sweep [options]" << endl
+       << "  --n 10,40,52             deck sizes (40)" << endl
+       << "  --space all|cutEasy|cutEasy2|top40" << endl
+       << "  --cipherZth L --cipherOffset L --cutZth L --cutOffset L" << endl
+       << "                           explicit space, the product of the lists" << endl
+       << "  --shard i/k              items i, i+k, i+2k, ... (0/1)" << endl
+       << "  --out FILE               csv to append to (sweep.csv, sweep-i-of-k.csv when sharded)" << endl
+       << "  --seed S                 (0)" << endl
+       << "  --zTrials Z --tTrials T --messageLen M --threads N" << endl
+       << "  --sprt ALPHA [--sprtDelta D]" << endl
+       << "                           stop a config once it is rejected at ALPHA" << endl
+       << "  --serial                 no DeckBatch lanes" << endl;
+}
+
+std::vector<int> ints(const std::string &list) {
+  std::vector<int> ans;
+  std::istringstream iss(list);
+  std::string item;
+  while (getline(iss,item,',')) {
+    ans.push_back(stoi(item));
+  }
+  return ans;
+}
+
+int main(int argc, char *argv[])
+{
+  Sweep sweep;
+  sweep.ns = {40};
+  std::string space = "all";
+  std::vector<int> cipherZths, cipherOffsets, cutZths, cutOffsets;
+  bool explicitSpace = false;
+  bool explicitOut = false;
+
+  try {
+    for (int i=1; i<argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--help" || arg == "-h") { usage(); return 0; }
+      if (arg == "--serial") { sweep.batch = false; continue; }
+      if (i+1 >= argc) throw std::invalid_argument(arg);
+      std::string value = argv[++i];
+      if (arg == "--n") sweep.ns = ints(value);
+      else if (arg == "--space") space = value;
+      else if (arg == "--cipherZth") { cipherZths = ints(value); explicitSpace = true; }
+      else if (arg == "--cipherOffset") { cipherOffsets = ints(value); explicitSpace = true; }
+      else if (arg == "--cutZth") { cutZths = ints(value); explicitSpace = true; }
+      else if (arg == "--cutOffset") { cutOffsets = ints(value); explicitSpace = true; }
+      else if (arg == "--shard") {
+	size_t slash = value.find('/');
+	if (slash == std::string::npos) throw std::invalid_argument(arg);
+	sweep.shard = stoi(value.substr(0,slash));
+	sweep.shards = stoi(value.substr(slash+1));
+      }
+      else if (arg == "--out") { sweep.path = value; explicitOut = true; }
+      else if (arg == "--seed") sweep.seed = stoull(value);
+      else if (arg == "--zTrials") sweep.zTrials = stoi(value);
+      else if (arg == "--tTrials") sweep.tTrials = stoi(value);
+      else if (arg == "--messageLen") sweep.messageLen = stoi(value);
+      else if (arg == "--sprt") sweep.sprtAlpha = stod(value);
+      else if (arg == "--sprtDelta") sweep.sprtDelta = stod(value);
+      else if (arg == "--threads") sweep.threads = stoi(value);
+      else throw std::invalid_argument(arg);
+    }
+  } catch (std::exception &e) {
+    cerr << "sweep: bad option " << e.what() << endl;
+    usage();
+    return 1;
+  }
+
+  if (sweep.shards < 1 || sweep.shard < 0 || sweep.shard >= sweep.shards) {
+    cerr << "sweep: shard must be i/k with 0 <= i < k" << endl;
+    return 1;
+  }
+
+  if (explicitSpace) {
+    DeckConfig cfg;
+    if (cipherZths.empty()) cipherZths = {cfg.cipherZth};
+    if (cipherOffsets.empty()) cipherOffsets = {cfg.cipherOffset};
+    if (cutZths.empty()) cutZths = {cfg.cutZth};
+    if (cutOffsets.empty()) cutOffsets = {cfg.cutOffset};
+    for (auto cipherZth : cipherZths) {
+      cfg.cipherZth = cipherZth;
+      for (auto cipherOffset : cipherOffsets) {
+	cfg.cipherOffset = cipherOffset;
+	for (auto cutZth : cutZths) {
+	  cfg.cutZth = cutZth;
+	  for (auto cutOffset : cutOffsets) {
+	    cfg.cutOffset = cutOffset;
+	    sweep.cfgs.push_back(cfg);
+	  }
+	}
+      }
+    }
+  } else if (space == "all") {
+    sweep.cfgs = configs();
+  } else if (space == "cutEasy") {
+    sweep.cfgs = configsCutEasy();
+  } else if (space == "cutEasy2") {
+    sweep.cfgs = configsCutEasy2();
+  } else if (space == "top40") {
+    sweep.cfgs = top40Configs();
+  } else {
+    cerr << "sweep: unknown space " << space << endl;
+    return 1;
+  }
+
+  if (!explicitOut && sweep.shards > 1) {
+    sweep.path = "sweep-" + std::to_string(sweep.shard) + "-of-" + std::to_string(sweep.shards) + ".csv";
+  }
+
+  try {
+    int resumed = sweep.resume();
+    size_t total = sweep.items().size();
+    cerr << "sweep: " << sweep.path << " has " << resumed << " of " << total << " rows" << endl;
+    sweep.run(cerr);
+  } catch (std::exception &e) {
+    cerr << "sweep: " << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -8,6 +8,7 @@
 
 #include "config.h"
 #include "messenger.h"
+#include "deck_kernel.h"
 
 namespace spider {
 
@@ -220,10 +221,12 @@ namespace spider {
 
   void Messenger::encrypt() {
     Deck work(m_key);
+    work.index();
+    DeckKernel kernel(work.cards.size(),work.boundConfig());
     for (int i=0; i<m_plaincards.size(); ++i) {
       Card plainCard = m_plaincards[i];
-      Card cipherPad = work.cipherPad();
-      Card cutPad = work.cutPad();
+      Card cipherPad = kernel.cipherPad(work);
+      Card cutPad = kernel.cutPad(work);
       Card cutCard = work.addMod(plainCard,cutPad);
       Card cipherCard = work.addMod(m_plaincards[i],cipherPad);
       if (DEBUG >= 100) {
@@ -236,11 +239,13 @@ namespace spider {
   
   void Messenger::decrypt() {
     Deck work(m_key);
+    work.index();
+    DeckKernel kernel(work.cards.size(),work.boundConfig());
     m_plaincards.clear();
     for (int i=0; i<m_ciphercards.size(); ++i) {
       Card cipherCard = m_ciphercards[i];
-      Card cipherPad = work.cipherPad();
-      Card cutPad = work.cutPad();
+      Card cipherPad = kernel.cipherPad(work);
+      Card cutPad = kernel.cutPad(work);
       Card plainCard = work.subMod(cipherCard,cipherPad);
       Card cutCard = work.addMod(plainCard,cutPad);
       if (DEBUG >= 100) {
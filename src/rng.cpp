@@ -1,39 +1,184 @@
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#if defined(__linux__)
+#include <sys/random.h>
+#endif
+
 #include "rng.h"
 
 namespace spider {
   
   uint32_t RNG::next_u32(uint32_t n) {
-    uint32_t x, r;
-    do {
-      x = next_u32();
-      r = x % n;
-    } while (x - r > uint32_t(-n));
-    return r;
+    return lemire(*this,n);
   }
   
   int RNG::next(int a, int b) {
     return a + int((b>a) ? next_u32(b-a+1) : 0);
   }
   
+  void RNG::fill(uint32_t *words, size_t n) {
+    for (size_t i=0; i<n; ++i) {
+      words[i]=next_u32();
+    }
+  }
+
   RNG::~RNG() {};
 
+  namespace {
+    // fill with os randomness, no partial results
+    void osRandom(void *buf, size_t n) {
+      uint8_t *at = (uint8_t*) buf;
+#if defined(__linux__)
+      while (n > 0) {
+	ssize_t got = getrandom(at,n,0);
+	if (got < 0) {
+	  if (errno == EINTR) continue;
+	  break; // ENOSYS: an old kernel, use /dev/urandom
+	}
+	at += got;
+	n -= got;
+      }
+      if (n == 0) return;
+#endif
+      FILE *urand = fopen("/dev/urandom","rb");
+      if (urand == 0 || fread(at,1,n,urand) != n) {
+	perror("/dev/urandom");
+	abort();
+      }
+      fclose(urand);
+    }
+
+    struct OsBuffer {
+      static const size_t WORDS = 256;
+      uint32_t words[WORDS];
+      size_t next;
+      OsBuffer() : next(WORDS) {}
+
+      void refill() {
+	static int forked = pthread_atfork(0,0,&OsBuffer::drop);
+	(void) forked;
+	osRandom(words,sizeof(words));
+	next = 0;
+      }
+
+      static void drop();
+    };
+
+    thread_local OsBuffer osBuffer;
+
+    void OsBuffer::drop() {
+      memset(osBuffer.words,0,sizeof(osBuffer.words));
+      osBuffer.next = WORDS;
+    }
+  }
+
   OS_RNG::OS_RNG() {
-    urand.open("/dev/urandom", std::ios::binary);
   }
   OS_RNG::~OS_RNG() {
   }
 
   uint32_t OS_RNG::next_u32() {
-    uint32_t x;
-    urand.read((char*) &x,sizeof(x));
+    OsBuffer &buffer = osBuffer;
+    if (buffer.next == OsBuffer::WORDS) {
+      buffer.refill();
+    }
+    uint32_t x = buffer.words[buffer.next];
+    buffer.words[buffer.next++] = 0;
     return x;
   }
 
+  void OS_RNG::fill(uint32_t *words, size_t n) {
+    OsBuffer &buffer = osBuffer;
+    while (n > 0 && buffer.next < OsBuffer::WORDS) {
+      *words++ = buffer.words[buffer.next];
+      buffer.words[buffer.next++] = 0;
+      --n;
+    }
+    if (n >= OsBuffer::WORDS) {
+      osRandom(words,n*sizeof(uint32_t));
+    } else {
+      for (size_t i=0; i<n; ++i) {
+	words[i] = next_u32();
+      }
+    }
+  }
+
   OS_RNG DEFAULT_OS_RNG;
 
   RNG& RNG::DEFAULT(DEFAULT_OS_RNG);
 
+  XOSHIRO_RNG::XOSHIRO_RNG(uint64_t seed) : m_spare(0), m_spared(false) {
+    SPLITMIX_RNG seeder(seed);
+    for (int i=0; i<4; ++i) {
+      m_state[i]=seeder.next_u64();
+    }
+  }
+
+  XOSHIRO_RNG::XOSHIRO_RNG(uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3) : m_spare(0), m_spared(false) {
+    m_state[0]=s0;
+    m_state[1]=s1;
+    m_state[2]=s2;
+    m_state[3]=s3;
+  }
+
+  void XOSHIRO_RNG::fill(uint32_t *words, size_t n) {
+    size_t i = 0;
+    if (m_spared && n > 0) {
+      words[i++] = m_spare;
+      m_spared = false;
+    }
+    // the state stays in registers for the whole run
+    uint64_t s0=m_state[0], s1=m_state[1], s2=m_state[2], s3=m_state[3];
+    for (; i+2 <= n; i += 2) {
+      uint64_t x = rotl(s1 * 5, 7) * 9;
+      uint64_t t = s1 << 17;
+      s2 ^= s0;
+      s3 ^= s1;
+      s1 ^= s2;
+      s0 ^= s3;
+      s2 ^= t;
+      s3 = rotl(s3, 45);
+      words[i] = uint32_t(x >> 32);
+      words[i+1] = uint32_t(x);
+    }
+    m_state[0]=s0; m_state[1]=s1; m_state[2]=s2; m_state[3]=s3;
+    if (i < n) {
+      words[i] = next_u32();
+    }
+  }
+
+  static void xoshiroJump(XOSHIRO_RNG &rng, const uint64_t (&poly)[4]) {
+    uint64_t s[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 4; ++i) {
+      for (int b = 0; b < 64; ++b) {
+	if (poly[i] & (uint64_t(1) << b)) {
+	  for (int k = 0; k < 4; ++k) {
+	    s[k] ^= rng.m_state[k];
+	  }
+	}
+	rng.next_u64();
+      }
+    }
+    for (int k = 0; k < 4; ++k) {
+      rng.m_state[k] = s[k];
+    }
+    rng.m_spared = false;
+  }
+
+  void XOSHIRO_RNG::jump() {
+    static const uint64_t JUMP[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    xoshiroJump(*this,JUMP);
+  }
+
+  void XOSHIRO_RNG::long_jump() {
+    static const uint64_t LONG_JUMP[4] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+    xoshiroJump(*this,LONG_JUMP);
+  }
+
   TEST_RNG::TEST_RNG(uint32_t state) : m_state(state) { }
   uint32_t TEST_RNG::next_u32() {
     ++m_state;
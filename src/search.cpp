@@ -1,16 +1,60 @@
 #include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include "search.h"
 
 
 namespace spider {
 
-  Search::Search(const Deck &_from, const Deck &_to) : from(_from), to(_to) {
+  namespace {
+    // work(0..threads-1), the last on this thread
+    template <typename Work>
+    void onThreads(int threads, Work work) {
+      std::vector<std::thread> workers;
+      for (int i=0; i<threads-1; ++i) {
+	workers.push_back(std::thread(work,i));
+      }
+      work(threads-1);
+      for (auto &worker : workers) worker.join();
+    }
+  }
+
+  Search::Search(const Deck &_from, const Deck &_to)
+    : forward(DeckCodec::PACKED,true), fboundary(DeckCodec::PACKED,true),
+      reverse(DeckCodec::PACKED,true), rboundary(DeckCodec::PACKED,true),
+      config(_from.boundConfig()), from(_from), to(_to) {
     cards=from.cards.size();
+    // workers see the config of this thread
+    from.bind(&config);
+    to.bind(&config);
+    from.index();
+    to.index();
     dist=0;
+    fdist=0;
+    rdist=0;
     maxDist = -1;
     duplicates=0;
     growth=0;
     all = false;
+    balance = true;
+    // per child over whole levels, pack, hash and lookups included
+    unmixCost = 1.6;
+    fexpansions = 0;
+    rexpansions = 0;
+    shortest = false;
+    countOnly = false;
+    count = 0;
+    m_halted = false;
+    threads = std::max(1u,std::thread::hardware_concurrency());
+    maxSeconds = 0;
+    maxBytes = 0;
+    stopped = false;
     forward.clear();
     reverse.clear();
     fboundary.clear();
@@ -19,8 +63,13 @@ namespace spider {
     rboundary.insert(to);
   }
 
+  bool Search::nextIsForward() const {
+    if (!balance) return dist % 2 == 0;
+    return double(fboundary.size()) <= unmixCost*rboundary.size();
+  }
+
   void Search::grow() {
-    if (dist % 2 == 0) {
+    if (nextIsForward()) {
       growForward();
     } else {
       growReverse();
@@ -28,104 +77,399 @@ namespace spider {
   }
 
   bool Search::done() const {
-    if (!all && paths.size() > 0) return true;
+    if ((!all || shortest) && found()) return true;
+    if (stopped || m_halted) return true;
     if (maxDist >= 0 && dist >= maxDist) return true;
     return false;
   }
 
   void Search::find() {
+    auto start = std::chrono::steady_clock::now();
+    stopped = false;
     while (!done()) {
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      if (overBudget(seconds)) {
+	stopped = true;
+	return;
+      }
       grow();
     }
   }
 
+  size_t Search::bytes() const {
+    return forward.bytes()+fboundary.bytes()+reverse.bytes()+rboundary.bytes();
+  }
+
+  // The next level buffers and keeps about a record, slot and link
+  // per child (the last level's growth, or one per card at first).
+  bool Search::overBudget(double seconds) const {
+    if (maxSeconds > 0 && seconds >= maxSeconds) return true;
+    if (maxBytes == 0) return false;
+    const SearchShards &boundary = nextIsForward() ? fboundary : rboundary;
+    double children = boundary.size()*(growth > 0 ? growth : cards);
+    size_t perChild = 2*boundary.recordBytes() + 2*sizeof(uint64_t);
+    return bytes() + children*perChild > maxBytes;
+  }
+
+  void Search::report(bool isForward, uint64_t children, uint64_t duplicates, double seconds) {
+    if (!progress) return;
+    SearchProgress level;
+    level.dist = dist;
+    level.isForward = isForward;
+    level.fboundary = fboundary.size();
+    level.rboundary = rboundary.size();
+    level.visited = forward.size()+reverse.size();
+    level.children = children;
+    level.duplicates = duplicates;
+    level.seconds = seconds;
+    level.bytes = bytes();
+    progress(level);
+  }
+
   void Search::growReverse() {
-    SearchSet newBoundary;
-    reverse.insert(rboundary.begin(), rboundary.end());
-
-    for (auto deck : rboundary) {
-      for (int order  = 0; order < cards; ++order) {
-	Card card(order);
-	Deck newDeck(deck);
-	newDeck.unmix(card);
-	if (fboundary.find(newDeck) != fboundary.end()) {
-	  paths.push_back(std::vector<Card>());
-	  std::vector<Card> &path = paths[paths.size()-1];
-	  if (newDeck != from) {
-	    Search recSearch(from,newDeck);
-	    recSearch.find();
-	    std::vector<Card> &toHere = recSearch.paths[0];
-	    path.insert(path.begin(),toHere.begin(),toHere.end());
-	  }
-	  path.push_back(card);
-	  if (deck != to) {
-	    Search recSearch(deck,to);
-	    recSearch.find();
-	    std::vector<Card> &fromHere = recSearch.paths[0];
-	    path.insert(path.end(),fromHere.begin(),fromHere.end());
-	  }
-	  if (!all) {
-	    return;
+    expand(false);
+  }
+
+  void Search::growForward() {
+    expand(true);
+  }
+
+  // One level of either side.  Workers take the boundary shards
+  // round robin; each child is packed once, with its link back to its
+  // parent's place in the visited set, checked against the other
+  // boundary (a meeting) and this side's visited set with no locks
+  // (neither changes during the level), and buffered by its shard in
+  // the worker's own buffers.  Then each worker inserts the buffered
+  // records of the shards it owns into the new boundary.
+  void Search::expand(bool isForward) {
+    auto start = std::chrono::steady_clock::now();
+    SearchShards &boundary = isForward ? fboundary : rboundary;
+    SearchShards &visited = isForward ? forward : reverse;
+    const SearchShards &other = isForward ? rboundary : fboundary;
+    int workers = std::max(1,std::min(threads,int(SearchShards::SHARDS)));
+
+    // the boundary lands at the end of each visited shard
+    std::vector<size_t> base(SearchShards::SHARDS);
+    for (int shard=0; shard<SearchShards::SHARDS; ++shard) {
+      base[shard] = visited.shard(shard).size();
+    }
+    visited.insert(boundary,workers);
+
+    SearchShards newBoundary(DeckCodec::PACKED,true);
+    newBoundary.shape(from);
+    size_t width = newBoundary.recordBytes();
+
+    std::vector<Expansion> work(workers);
+    // With all false, the edgeOrder of the first meeting found so far.
+    // A worker stops once its next state is past it, so the first
+    // meeting of the level is always found, whatever the workers.
+    std::atomic<uint64_t> first(UINT64_MAX);
+
+    onThreads(workers,[&](int worker) {
+	Expansion &mine = work[worker];
+	mine.records.resize(SearchShards::SHARDS);
+	uint8_t rec[SearchSet::MAX_RECORD_BYTES];
+	for (int shard=worker; shard<SearchShards::SHARDS; shard += workers) {
+	  const SearchSet &decks = boundary.shard(shard);
+	  for (size_t record=0; record<decks.size(); ++record) {
+	    if (!all && edgeOrder(shard,record,0) > first.load(std::memory_order_relaxed)) return;
+	    Deck deck = decks.deck(record);
+	    for (int order = 0; order < cards; ++order) {
+	      ++mine.children;
+	      Deck newDeck(deck);
+	      if (isForward) {
+		newDeck.mix(Card(order));
+	      } else {
+		newDeck.unmix(Card(order));
+	      }
+	      newBoundary.pack(newDeck,rec,link(shard,base[shard]+record,order));
+	      uint64_t hash = newBoundary.hash(rec);
+	      const SearchSet &meets = other.shard(SearchShards::shardOf(hash));
+	      auto met = meets.findRecord(rec,hash);
+	      if (met != meets.end()) {
+		mine.meets.push_back(Meet{shard,record,order,SearchShards::shardOf(hash),met.record()});
+		if (!all) {
+		  uint64_t at = edgeOrder(shard,record,order), was = first.load();
+		  while (at < was && !first.compare_exchange_weak(was,at)) {}
+		  break;
+		}
+	      } else if (visited.containsRecord(rec,hash)) {
+		++mine.duplicates;
+	      } else {
+		std::vector<uint8_t> &out = mine.records[SearchShards::shardOf(hash)];
+		out.insert(out.end(),rec,rec+width);
+	      }
+	    }
 	  }
-	} else if (reverse.find(newDeck) == reverse.end()) {
-	  newBoundary.insert(newDeck);
+	}
+      });
+
+    std::vector<Meet> meets;
+    uint64_t children = 0, seen = 0;
+    for (auto &mine : work) {
+      duplicates += mine.duplicates;
+      children += mine.children;
+      seen += mine.duplicates;
+      meets.insert(meets.end(),mine.meets.begin(),mine.meets.end());
+    }
+    (isForward ? fexpansions : rexpansions) += children;
+
+    if (meets.size() > 0) {
+      // boundary order, whichever worker got there first
+      std::sort(meets.begin(),meets.end(),[](const Meet &a, const Meet &b) {
+	  if (a.shard != b.shard) return a.shard < b.shard;
+	  if (a.record != b.record) return a.record < b.record;
+	  return a.card < b.card;
+	});
+      m_ways.clear();
+      for (auto &meet : meets) {
+	const SearchSet &mine = visited.shard(meet.shard);
+	const SearchSet &theirs = other.shard(meet.otherShard);
+	size_t record = base[meet.shard]+meet.record;
+	bool more;
+	if (isForward) {
+	  more = addPaths(mine,record,Card(meet.card),theirs,meet.otherRecord);
 	} else {
-	  ++duplicates;
+	  more = addPaths(theirs,meet.otherRecord,Card(meet.card),mine,record);
 	}
+	if (!more) m_halted = true;
+	if (!all || m_halted) break;
+      }
+      m_ways.clear();
+      if (!all || m_halted) {
+	report(isForward,children,seen,std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count());
+	return;
       }
     }
-    growth = double(newBoundary.size())/double(rboundary.size());
-    rboundary.swap(newBoundary);
-    ++dist;
-  }
 
-  void Search::growForward() {
-    SearchSet newBoundary;
-    forward.insert(fboundary.begin(), fboundary.end());
-   
-    for (auto deck : fboundary) {
-      for (int order  = 0; order < cards; ++order) {
-	Card card(order);
-	Deck newDeck(deck);
-	newDeck.mix(Card(card));
-	if (rboundary.find(newDeck) != rboundary.end()) {
-	  paths.push_back(std::vector<Card>());
-	  std::vector<Card> &path=paths[paths.size()-1];
-	  if (deck != from) {
-	    Search recSearch(from,deck);
-	    recSearch.find();
-	    std::vector<Card> &toHere=recSearch.paths[0];
-	    path.insert(path.begin(),toHere.begin(),toHere.end());
-	  }
-	  path.push_back(card);
-	  if (newDeck != to) {
-	    Search recSearch(newDeck,to);
-	    recSearch.find();
-	    std::vector<Card> &fromHere=recSearch.paths[0];
-	    path.insert(path.end(),fromHere.begin(),fromHere.end());
+    // Each worker's buffers are in edge order, so merging them by the
+    // edge of their parent links inserts as one worker would: the
+    // records, and the parent kept when all is false, do not depend
+    // on the workers.
+    onThreads(workers,[&](int worker) {
+	std::vector<size_t> at(workers);
+	for (int shard=worker; shard<SearchShards::SHARDS; shard += workers) {
+	  SearchSet &into = newBoundary.shard(shard);
+	  std::fill(at.begin(),at.end(),0);
+	  for (;;) {
+	    int next = -1;
+	    uint64_t nextOrder = 0, parent = 0;
+	    for (int w=0; w<workers; ++w) {
+	      const std::vector<uint8_t> &in = work[w].records[shard];
+	      if (at[w] >= in.size()) continue;
+	      uint64_t link;
+	      memcpy(&link,&in[at[w]]+width-sizeof(link),sizeof(link));
+	      if (next < 0 || edgeOrder(link) < nextOrder) {
+		next = w;
+		nextOrder = edgeOrder(link);
+		parent = link;
+	      }
+	    }
+	    if (next < 0) break;
+	    const uint8_t *rec = &work[next].records[shard][at[next]];
+	    at[next] += width;
+	    uint64_t hash = into.hash(rec);
+	    if (into.insertRecord(rec,hash) || !all) continue;
+	    // another parent at the same distance: another way here
+	    into.addLink(into.findRecord(rec,hash).record(),parent);
 	  }
-	  if (!all) {
-	    return;
-	  }
-	} else if (forward.find(newDeck) == forward.end()) {
-	  newBoundary.insert(newDeck);
-	} else {
-	  ++duplicates;
+	  for (auto &mine : work) std::vector<uint8_t>().swap(mine.records[shard]);
 	}
+      });
+
+    growth = double(newBoundary.size())/double(boundary.size());
+    // children that were neither meetings nor new states
+    seen = children-meets.size()-newBoundary.size();
+    boundary.swap(newBoundary);
+    ++dist;
+    ++(isForward ? fdist : rdist);
+    report(isForward,children,seen,std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count());
+  }
+
+  namespace {
+    // S3: seven counts, the DeckConfig and the expansions of each side
+    const char SEARCH_MAGIC[8] = {'s','p','i','d','e','r','S','3'};
+
+    bool putDeck(FILE *file, const Deck &deck) {
+      uint8_t orders[Deck::MAX_SIZE];
+      for (size_t i=0; i<deck.cards.size(); ++i) orders[i] = deck.cards[i].order;
+      return fwrite(orders,1,deck.cards.size(),file) == deck.cards.size();
+    }
+
+    bool getDeck(FILE *file, int n, Deck &deck) {
+      uint8_t orders[Deck::MAX_SIZE];
+      if (n <= 0 || n > int(Deck::MAX_SIZE) || fread(orders,1,n,file) != size_t(n)) return false;
+      Deck ans(n);
+      for (int i=0; i<n; ++i) ans.cards[i] = Card(orders[i]);
+      ans.bind(&deck.boundConfig());
+      ans.index();
+      deck = ans;
+      return true;
+    }
+  }
+
+  // The magic, the counts, the config, from and to as card orders, the
+  // four sets, then the paths, written to a temporary file renamed over
+  // path so an interrupted save keeps the last one.
+  void Search::save(const std::string &path) const {
+    if (m_halted) throw std::runtime_error("a search halted by onPath cannot be saved to " + path);
+    std::string tmp = path + ".tmp";
+    FILE *file = fopen(tmp.c_str(),"wb");
+    if (file == 0) throw std::runtime_error("could not create " + tmp);
+    int32_t counts[7] = {cards, maxDist, dist, fdist, rdist, duplicates, all};
+    int32_t cfg[4] = {config.cipherZth, config.cipherOffset, config.cutZth, config.cutOffset};
+    uint64_t expansions[2] = {fexpansions, rexpansions};
+    bool ok = fwrite(SEARCH_MAGIC,sizeof(SEARCH_MAGIC),1,file) == 1;
+    ok = ok && fwrite(counts,sizeof(counts),1,file) == 1 && fwrite(cfg,sizeof(cfg),1,file) == 1;
+    ok = ok && fwrite(&growth,sizeof(growth),1,file) == 1;
+    ok = ok && fwrite(&count,sizeof(count),1,file) == 1 && fwrite(expansions,sizeof(expansions),1,file) == 1;
+    ok = ok && putDeck(file,from) && putDeck(file,to);
+    ok = ok && forward.write(file) && fboundary.write(file) && reverse.write(file) && rboundary.write(file);
+    uint64_t listed = paths.size();
+    ok = ok && fwrite(&listed,sizeof(listed),1,file) == 1;
+    for (size_t i=0; ok && i<paths.size(); ++i) {
+      uint32_t length = paths[i].size();
+      ok = fwrite(&length,sizeof(length),1,file) == 1;
+      for (size_t k=0; ok && k<length; ++k) ok = fwrite(&paths[i][k].order,1,1,file) == 1;
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) throw std::runtime_error("could not write " + tmp);
+    if (rename(tmp.c_str(),path.c_str()) != 0) {
+      throw std::runtime_error("could not replace " + path);
+    }
+  }
+
+  void Search::load(const std::string &path) {
+    FILE *file = fopen(path.c_str(),"rb");
+    if (file == 0) throw std::runtime_error("could not open " + path);
+    char magic[sizeof(SEARCH_MAGIC)];
+    int32_t counts[7];
+    int32_t cfg[4];
+    uint64_t expansions[2];
+    double rate;
+    uint64_t total;
+    Deck a(from), b(to);
+    SearchShards f(DeckCodec::PACKED,true), fb(DeckCodec::PACKED,true);
+    SearchShards r(DeckCodec::PACKED,true), rb(DeckCodec::PACKED,true);
+    std::vector < std::vector<Card> > found;
+    bool ok = fread(magic,sizeof(magic),1,file) == 1 && memcmp(magic,SEARCH_MAGIC,sizeof(magic)) == 0;
+    ok = ok && fread(counts,sizeof(counts),1,file) == 1 && fread(cfg,sizeof(cfg),1,file) == 1;
+    ok = ok && fread(&rate,sizeof(rate),1,file) == 1;
+    ok = ok && fread(&total,sizeof(total),1,file) == 1 && fread(expansions,sizeof(expansions),1,file) == 1;
+    ok = ok && getDeck(file,counts[0],a) && getDeck(file,counts[0],b);
+    ok = ok && f.read(file,a) && fb.read(file,a) && r.read(file,a) && rb.read(file,a);
+    uint64_t listed = 0;
+    ok = ok && fread(&listed,sizeof(listed),1,file) == 1;
+    for (uint64_t i=0; ok && i<listed; ++i) {
+      uint32_t length;
+      ok = fread(&length,sizeof(length),1,file) == 1;
+      std::vector<Card> path;
+      for (uint32_t k=0; ok && k<length; ++k) {
+	uint8_t order;
+	ok = fread(&order,1,1,file) == 1;
+	path.push_back(Card(order));
       }
+      found.push_back(path);
     }
-    growth = double(newBoundary.size())/double(fboundary.size());
-    fboundary.swap(newBoundary);
-    ++dist;
-  };
+    fclose(file);
+    if (!ok) throw std::runtime_error("could not read " + path);
+
+    cards = counts[0];
+    maxDist = counts[1];
+    dist = counts[2];
+    fdist = counts[3];
+    rdist = counts[4];
+    duplicates = counts[5];
+    all = counts[6] != 0;
+    fexpansions = expansions[0];
+    rexpansions = expansions[1];
+    growth = rate;
+    count = total;
+    // the search goes on under the config it began with: from, to and
+    // the sets are bound to config
+    config.cipherZth = cfg[0];
+    config.cipherOffset = cfg[1];
+    config.cutZth = cfg[2];
+    config.cutOffset = cfg[3];
+    from = a;
+    to = b;
+    forward.swap(f);
+    fboundary.swap(fb);
+    reverse.swap(r);
+    rboundary.swap(rb);
+    paths.swap(found);
+    stopped = false;
+    m_halted = false;
+  }
+
+  bool Search::eachWay(const SearchSet &set, size_t record, bool isForward, std::vector<Card> &cards, const std::function<bool(const std::vector<Card> &)> &each) const {
+    const SearchShards &visited = isForward ? forward : reverse;
+    std::vector<uint64_t> links;
+    if (all) {
+      set.links(record,links);
+    } else {
+      links.assign(1,set.link(record));
+    }
+    for (auto link : links) {
+      if (link == 0) {
+	if (!each(cards)) return false;
+	continue;
+      }
+      cards.push_back(Card(int(link >> 40)-1));
+      bool more = eachWay(visited.shard((link >> 32) & 0xff),uint32_t(link),isForward,cards,each);
+      cards.pop_back();
+      if (!more) return false;
+    }
+    return true;
+  }
+
+  uint64_t Search::ways(const SearchSet &set, size_t record, bool isForward) {
+    auto key = std::make_pair(&set,record);
+    auto known = m_ways.find(key);
+    if (known != m_ways.end()) return known->second;
+    const SearchShards &visited = isForward ? forward : reverse;
+    std::vector<uint64_t> links;
+    if (all) {
+      set.links(record,links);
+    } else {
+      links.assign(1,set.link(record));
+    }
+    uint64_t ans = 0;
+    for (auto link : links) {
+      ans += (link == 0) ? 1 : ways(visited.shard((link >> 32) & 0xff),uint32_t(link),isForward);
+    }
+    m_ways[key] = ans;
+    return ans;
+  }
+
+  // Heads are read back to front from the forward state, tails in
+  // order from the reverse one, so a path at a time is held.
+  bool Search::addPaths(const SearchSet &fset, size_t before, const Card &card, const SearchSet &rset, size_t after) {
+    if (countOnly && !onPath) {
+      count += ways(fset,before,true)*ways(rset,after,false);
+      return true;
+    }
+    std::vector<Card> head, tail, path;
+    return eachWay(fset,before,true,head,[&](const std::vector<Card> &back) {
+	return eachWay(rset,after,false,tail,[&](const std::vector<Card> &rest) {
+	    path.assign(back.rbegin(),back.rend());
+	    path.push_back(card);
+	    path.insert(path.end(),rest.begin(),rest.end());
+	    ++count;
+	    if (onPath) return onPath(path);
+	    paths.push_back(path);
+	    return true;
+	  });
+      });
+  }
 
   bool Search::found() const {
-    return paths.size() > 0;
+    return count > 0;
   }
 
-  bool SearchLite(const Deck &from, int fromDist, 
-		  const Deck &to, int toDist, 
-		  std::vector<int> &path, bool cycle) {
+  bool SearchLiteDepthFirst(const Deck &from, int fromDist, 
+			    const Deck &to, int toDist, 
+			    std::vector<int> &path, bool cycle) {
 
     if (from == to && !cycle) {
       return true;
@@ -140,7 +484,7 @@ namespace spider {
       for (int i=0; i<n; ++i) {
 	Deck::cut(step.cards,i,temp1.cards);
 	Deck::backFrontShuffle(temp1.cards,temp2.cards);
-	if (SearchLite(temp2, fromDist-1, to, toDist, path)) {
+	if (SearchLiteDepthFirst(temp2, fromDist-1, to, toDist, path)) {
 	  path.insert(path.begin(),i);
 	  return true;
 	}
@@ -155,7 +499,7 @@ namespace spider {
       for (int i=0; i<n; ++i) {
 	Deck::backFrontUnshuffle(step.cards,temp1.cards);
 	Deck::cut(temp1.cards,n-i,temp2.cards);
-	if (SearchLite(from, fromDist, temp2, toDist-1, path)) {
+	if (SearchLiteDepthFirst(from, fromDist, temp2, toDist-1, path)) {
 	  path.push_back(i);
 	  return true;
 	}
@@ -165,6 +509,375 @@ namespace spider {
 
     return false;
   }
-}
 
+  namespace {
+    // The reverse steps of a SearchLite table entry: step k in bits
+    // 6k..6k+5, the count in the top bits.
+    const int MAX_TABLE_DIST = 9;
+  }
+
+  // Every level can hold n^depth states: the records, and about two
+  // 8 byte slots each, of n^0+...+n^toDist states, below 2^32 records
+  // as the slots keep 32 bit record numbers.
+  int SearchLiteTableDist(const Deck &to, int toDist) {
+    SearchSet table(DeckCodec::PACKED,true,false);
+    table.shape(to);
+    double perRecord = table.recordBytes() + 2*sizeof(uint64_t);
+    double records = 0, level = 1;
+    for (int depth=0; depth<=std::min(toDist,MAX_TABLE_DIST); ++depth, level *= to.cards.size()) {
+      records += level;
+      if (records >= 4294967295.0 || records*perRecord > double(SEARCH_LITE_TABLE_BYTES)) return depth-1;
+    }
+    return std::min(toDist,MAX_TABLE_DIST);
+  }
+
+  namespace {
 
+    // every state toDist or fewer reverse steps from at, keeping the
+    // first steps to reach it in the depth first order
+    void reachBack(const Deck &at, int depth, int toDist, uint64_t steps, bool skip, SearchSet &table) {
+      if (!skip) {
+	uint8_t rec[SearchSet::MAX_RECORD_BYTES];
+	table.shape(at);
+	table.pack(at,rec,(uint64_t(depth) << 58) | steps);
+	table.insertRecord(rec,table.hash(rec));
+      }
+      if (depth == toDist) return;
+      int n = at.cards.size();
+      Deck unshuffled(at);
+      Deck next(at);
+      Deck::backFrontUnshuffle(at.cards,unshuffled.cards);
+      for (int i=0; i<n; ++i) {
+	Deck::cut(unshuffled.cards,n-i,next.cards);
+	reachBack(next,depth+1,toDist,steps | (uint64_t(i) << (6*depth)),false,table);
+      }
+    }
+
+    // the first forward steps, depth first, to a state of the table
+    // (or to `to` itself before fromDist steps)
+    bool reachForward(const Deck &at, int depth, int fromDist, const Deck &to, bool skip, const SearchSet &table, std::vector<int> &steps, uint64_t &back) {
+      if (depth < fromDist) {
+	if (!skip && at == to) {
+	  back = 0;
+	  return true;
+	}
+	int n = at.cards.size();
+	for (int i=0; i<n; ++i) {
+	  Deck next(at);
+	  Deck::cutBackFrontShuffle(next.cards.data(),n,i);
+	  steps.push_back(i);
+	  if (reachForward(next,depth+1,fromDist,to,false,table,steps,back)) return true;
+	  steps.pop_back();
+	}
+	return false;
+      }
+      if (table.empty()) return false;
+      uint8_t rec[SearchSet::MAX_RECORD_BYTES];
+      table.pack(at,rec);
+      auto found = table.findRecord(rec,table.hash(rec));
+      if (found == table.end()) return false;
+      back = table.link(found.record());
+      return true;
+    }
+  }
+
+  // Meet in the middle: the states within toDist reverse steps of to
+  // go in a table (keyed exactly, ==), then a depth first walk of the
+  // forward steps looks each of its states up.  Entries keep the first
+  // reverse steps in the order the recursion would try them, so the
+  // path is the one it would have found, for n^fromDist + n^toDist
+  // steps instead of n^(fromDist+toDist).
+  bool SearchLite(const Deck &from, int fromDist, 
+		  const Deck &to, int toDist, 
+		  std::vector<int> &path, bool cycle) {
+    // the reverse steps past a table that fits are walked forward
+    int tableDist = std::max(0,SearchLiteTableDist(to,toDist));
+    fromDist += toDist-tableDist;
+    toDist = tableDist;
+
+    SearchSet table(DeckCodec::PACKED,true,false);
+    // a cycle must take a step
+    reachBack(to,0,toDist,0,cycle && fromDist == 0,table);
+
+    std::vector<int> steps;
+    uint64_t back = 0;
+    if (!reachForward(from,0,fromDist,to,cycle,table,steps,back)) {
+      return false;
+    }
+    path.insert(path.begin(),steps.begin(),steps.end());
+    for (int k=int(back >> 58)-1; k >= 0; --k) {
+      path.push_back((back >> (6*k)) & 63);
+    }
+    return true;
+  }
+
+  namespace {
+    // forward steps a parallel SearchLite task can hold
+    const int MAX_LITE_DIST = 64;
+
+    struct LiteTask {
+      Deck at;
+      int depth;
+      int steps[MAX_LITE_DIST];
+      LiteTask(const Deck &_at) : at(_at), depth(0) {}
+    };
+
+    // Each worker takes its own newest task and, when it has none,
+    // steals the oldest of another, so a lone worker walks depth first
+    // and thieves take the biggest subtrees left.
+    class StealingPool {
+    public:
+      StealingPool(int workers) : m_queues(workers), m_locks(workers), m_pending(0) {}
+
+      void push(int worker, const LiteTask &task) {
+	m_pending.fetch_add(1);
+	std::lock_guard<std::mutex> hold(m_locks[worker]);
+	m_queues[worker].push_back(task);
+      }
+
+      // the next task of worker, or false once every task is done
+      bool pop(int worker, LiteTask &task) {
+	int workers = m_queues.size();
+	for (;;) {
+	  for (int k=0; k<workers; ++k) {
+	    int victim = (worker+k) % workers;
+	    std::lock_guard<std::mutex> hold(m_locks[victim]);
+	    std::deque<LiteTask> &queue = m_queues[victim];
+	    if (queue.empty()) continue;
+	    if (k == 0) {
+	      task = queue.back();
+	      queue.pop_back();
+	    } else {
+	      task = queue.front();
+	      queue.pop_front();
+	    }
+	    return true;
+	  }
+	  if (m_pending.load() == 0) return false;
+	  std::this_thread::yield();
+	}
+      }
+
+      // a popped task (and the tasks it pushed) is finished
+      void done() {
+	m_pending.fetch_sub(1);
+      }
+
+    private:
+      std::vector< std::deque<LiteTask> > m_queues;
+      std::vector<std::mutex> m_locks;
+      // tasks pushed and not yet done
+      std::atomic<int> m_pending;
+    };
+
+    // The forward walk of SearchLiteParallel and SearchLiteAll.  Tasks
+    // above split push a task per step; the rest walk depth first.
+    // Words are the forward steps, in depth first order, and the link
+    // of the table entry they meet (0 for `to` itself).
+    struct LiteWalk {
+      const Deck &to;
+      const SearchSet &table;
+      int fromDist, split;
+      bool cycle, all;
+
+      std::mutex lock;
+      // the first word found, and a count of improvements to it
+      bool found;
+      std::vector<int> best;
+      uint64_t back;
+      std::atomic<uint32_t> version;
+      // every word, by worker, when all
+      std::vector< std::vector< std::pair<std::vector<int>,uint64_t> > > words;
+
+      LiteWalk(const Deck &_to, const SearchSet &_table, int _fromDist, bool _cycle, bool _all)
+	: to(_to), table(_table), fromDist(_fromDist), split(0), cycle(_cycle), all(_all), found(false), back(0), version(0) {}
+
+      // is every word starting with steps after the first found
+      bool behind(const int *steps, int depth) {
+	std::lock_guard<std::mutex> hold(lock);
+	return found && std::lexicographical_compare(best.begin(),best.end(),steps,steps+depth);
+      }
+
+      void report(int worker, const int *steps, int depth, uint64_t link) {
+	if (all) {
+	  words[worker].push_back(std::make_pair(std::vector<int>(steps,steps+depth),link));
+	  return;
+	}
+	std::lock_guard<std::mutex> hold(lock);
+	if (!found || std::lexicographical_compare(steps,steps+depth,best.begin(),best.end())) {
+	  found = true;
+	  best.assign(steps,steps+depth);
+	  back = link;
+	  version.fetch_add(1);
+	}
+      }
+
+      bool meets(int worker, const Deck &at, const int *steps, int depth) {
+	if (table.empty()) return false;
+	uint8_t rec[SearchSet::MAX_RECORD_BYTES];
+	table.pack(at,rec);
+	auto entry = table.findRecord(rec,table.hash(rec));
+	if (entry == table.end()) return false;
+	if (all) {
+	  std::vector<uint64_t> links;
+	  table.links(entry.record(),links);
+	  for (auto link : links) report(worker,steps,depth,link);
+	} else {
+	  report(worker,steps,depth,table.link(entry.record()));
+	}
+	return true;
+      }
+
+      // depth first from at; true to stop: a word found, or every word
+      // here is after one found elsewhere
+      bool walk(int worker, const Deck &at, int depth, bool skip, int *steps, uint32_t &seen) {
+	if (!all) {
+	  uint32_t now = version.load(std::memory_order_relaxed);
+	  if (now != seen) {
+	    seen = now;
+	    if (behind(steps,depth)) return true;
+	  }
+	}
+	if (depth == fromDist) {
+	  return meets(worker,at,steps,depth) && !all;
+	}
+	if (!all && !skip && at == to) {
+	  report(worker,steps,depth,0);
+	  return true;
+	}
+	int n = at.cards.size();
+	for (int i=0; i<n; ++i) {
+	  Deck next(at);
+	  Deck::cutBackFrontShuffle(next.cards.data(),n,i);
+	  steps[depth] = i;
+	  if (walk(worker,next,depth+1,false,steps,seen)) return true;
+	}
+	return false;
+      }
+
+      void run(StealingPool &pool, int worker, LiteTask &task) {
+	bool skip = cycle && task.depth == 0;
+	if (task.depth >= split) {
+	  uint32_t seen = ~version.load();
+	  walk(worker,task.at,task.depth,skip,task.steps,seen);
+	  return;
+	}
+	if (!all && behind(task.steps,task.depth)) return;
+	if (!all && !skip && task.at == to) {
+	  report(worker,task.steps,task.depth,0);
+	  return;
+	}
+	int n = task.at.cards.size();
+	// the newest is taken first: push the last step first
+	for (int i=n-1; i>=0; --i) {
+	  LiteTask child(task);
+	  Deck::cutBackFrontShuffle(child.at.cards.data(),n,i);
+	  child.steps[child.depth++] = i;
+	  pool.push(worker,child);
+	}
+      }
+
+      void run(const Deck &from, int threads) {
+	if (threads <= 0) threads = std::max(1u,std::thread::hardware_concurrency());
+	// enough tasks to go around
+	int n = from.cards.size();
+	double tasks = 1;
+	for (split = 0; split < fromDist && tasks < 8*threads; ++split) tasks *= n;
+	words.assign(threads,std::vector< std::pair<std::vector<int>,uint64_t> >());
+
+	StealingPool pool(threads);
+	pool.push(threads-1,LiteTask(from));
+	onThreads(threads,[&](int worker) {
+	    LiteTask task(from);
+	    while (pool.pop(worker,task)) {
+	      run(pool,worker,task);
+	      pool.done();
+	    }
+	  });
+      }
+    };
+
+    // the steps of a word: forward, then the table link's in reverse
+    std::vector<int> liteWord(const std::vector<int> &steps, uint64_t back) {
+      std::vector<int> ans(steps);
+      for (int k=int(back >> 58)-1; k >= 0; --k) {
+	ans.push_back((back >> (6*k)) & 63);
+      }
+      return ans;
+    }
+
+    // every state exactly toDist reverse steps from at, linked to every
+    // word of reverse steps that reaches it
+    void reachBackAll(const Deck &at, int depth, int toDist, uint64_t steps, SearchSet &table) {
+      if (depth == toDist) {
+	uint8_t rec[SearchSet::MAX_RECORD_BYTES];
+	uint64_t link = (uint64_t(depth) << 58) | steps;
+	table.shape(at);
+	table.pack(at,rec,link);
+	uint64_t hash = table.hash(rec);
+	if (!table.insertRecord(rec,hash)) {
+	  table.addLink(table.findRecord(rec,hash).record(),link);
+	}
+	return;
+      }
+      int n = at.cards.size();
+      Deck unshuffled(at);
+      Deck next(at);
+      Deck::backFrontUnshuffle(at.cards,unshuffled.cards);
+      for (int i=0; i<n; ++i) {
+	Deck::cut(unshuffled.cards,n-i,next.cards);
+	reachBackAll(next,depth+1,toDist,steps | (uint64_t(i) << (6*depth)),table);
+      }
+    }
+  }
+
+  bool SearchLiteParallel(const Deck &from, int fromDist,
+			  const Deck &to, int toDist,
+			  std::vector<int> &path, bool cycle, int threads) {
+    int tableDist = std::max(0,SearchLiteTableDist(to,toDist));
+    fromDist += toDist-tableDist;
+    toDist = tableDist;
+    if (fromDist > MAX_LITE_DIST) {
+      return SearchLiteDepthFirst(from,fromDist,to,toDist,path,cycle);
+    }
+
+    SearchSet table(DeckCodec::PACKED,true,false);
+    reachBack(to,0,toDist,0,cycle && fromDist == 0,table);
+
+    LiteWalk walk(to,table,fromDist,cycle,false);
+    walk.run(from,threads);
+    if (!walk.found) return false;
+    std::vector<int> word = liteWord(walk.best,walk.back);
+    auto middle = word.begin()+walk.best.size();
+    path.insert(path.begin(),word.begin(),middle);
+    path.insert(path.end(),middle,word.end());
+    return true;
+  }
+
+  // Lengths in turn, each split in half between a table of the reverse
+  // words and a forward walk, until one has words.  The walk takes the
+  // steps past a table that would be too big.
+  int SearchLiteAll(const Deck &from, const Deck &to, int maxDist,
+		    std::vector< std::vector<int> > &paths, bool cycle, int threads) {
+    paths.clear();
+    int maxToDist = SearchLiteTableDist(to,maxDist/2);
+    for (int len = cycle ? 1 : 0; len <= maxDist; ++len) {
+      int toDist = std::min(len/2,maxToDist);
+      int fromDist = len-toDist;
+      if (fromDist > MAX_LITE_DIST) break;
+
+      SearchSet table(DeckCodec::PACKED,true,false);
+      reachBackAll(to,0,toDist,0,table);
+      LiteWalk walk(to,table,fromDist,cycle,true);
+      walk.run(from,threads);
+      for (auto &words : walk.words) {
+	for (auto &word : words) paths.push_back(liteWord(word.first,word.second));
+      }
+      if (!paths.empty()) {
+	std::sort(paths.begin(),paths.end());
+	return len;
+      }
+    }
+    return -1;
+  }
+}
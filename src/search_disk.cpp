@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+
+#include "search_disk.h"
+
+namespace spider {
+
+  namespace {
+    // stdio buffer of each open level or run
+    const size_t FILE_BUFFER = size_t(1) << 16;
+
+    // sorted fixed width keys from a file, one at a time
+    struct KeyReader {
+      FILE *file;
+      size_t width;
+      std::vector<uint8_t> key;
+      bool ok;
+
+      KeyReader(const std::string &path, size_t _width) : width(_width), key(_width), ok(false) {
+	file = fopen(path.c_str(),"rb");
+	if (file == 0) throw std::runtime_error("could not open " + path);
+	setvbuf(file,0,_IOFBF,FILE_BUFFER);
+	next();
+      }
+      ~KeyReader() { fclose(file); }
+
+      bool next() {
+	ok = fread(key.data(),width,1,file) == 1;
+	return ok;
+      }
+
+      // move to the first key >= to; true if it is equal
+      bool seek(const uint8_t *to) {
+	while (ok) {
+	  int cmp = memcmp(key.data(),to,width);
+	  if (cmp == 0) return true;
+	  if (cmp > 0) return false;
+	  next();
+	}
+	return false;
+      }
+    };
+
+    struct KeyWriter {
+      FILE *file;
+      std::string path;
+      size_t width;
+      uint64_t count;
+
+      KeyWriter(const std::string &_path, size_t _width) : path(_path), width(_width), count(0) {
+	file = fopen(path.c_str(),"wb");
+	if (file == 0) throw std::runtime_error("could not create " + path);
+	setvbuf(file,0,_IOFBF,FILE_BUFFER);
+      }
+      ~KeyWriter() { if (file != 0) fclose(file); }
+
+      void write(const uint8_t *key) {
+	if (fwrite(key,width,1,file) != 1) throw std::runtime_error("could not write " + path);
+	++count;
+      }
+
+      void close() {
+	bool bad = ferror(file) != 0;
+	bad = (fclose(file) != 0) || bad;
+	file = 0;
+	if (bad) throw std::runtime_error("could not write " + path);
+      }
+    };
+
+    // the unique keys of runs, in order, through a heap of readers
+    struct KeyMerge {
+      size_t width;
+      std::vector< std::unique_ptr<KeyReader> > readers;
+      std::vector<KeyReader*> heap;
+      std::vector<uint8_t> key;
+      uint64_t taken;
+
+      static bool after(const KeyReader *a, const KeyReader *b) {
+	return memcmp(a->key.data(),b->key.data(),a->width) > 0;
+      }
+
+      KeyMerge(const std::vector<std::string> &runs, size_t _width) : width(_width), key(_width), taken(0) {
+	for (auto &run : runs) {
+	  readers.push_back(std::unique_ptr<KeyReader>(new KeyReader(run,width)));
+	  if (readers.back()->ok) heap.push_back(readers.back().get());
+	}
+	std::make_heap(heap.begin(),heap.end(),after);
+      }
+
+      // the next distinct key; taken counts every copy
+      bool next() {
+	if (heap.empty()) return false;
+	memcpy(key.data(),heap.front()->key.data(),width);
+	while (!heap.empty() && memcmp(heap.front()->key.data(),key.data(),width) == 0) {
+	  std::pop_heap(heap.begin(),heap.end(),after);
+	  KeyReader *reader = heap.back();
+	  heap.pop_back();
+	  ++taken;
+	  if (reader->next()) {
+	    heap.push_back(reader);
+	    std::push_heap(heap.begin(),heap.end(),after);
+	  }
+	}
+	return true;
+      }
+    };
+
+    uint64_t fileBytes(const std::string &path) {
+      struct stat st;
+      return stat(path.c_str(),&st) == 0 ? uint64_t(st.st_size) : 0;
+    }
+  }
+
+  SearchDisk::SearchDisk(const Deck &_from, const Deck &_to, const std::string &_dir, size_t _memory, DeckCodec::Format format)
+    : memory(_memory), dir(_dir), codec(_from.cards.size(),format), config(_from.boundConfig()), from(_from), to(_to) {
+    cards=from.cards.size();
+    // decoded decks are bound to config too
+    from.bind(&config);
+    to.bind(&config);
+    from.index();
+    to.index();
+    dist=0;
+    maxDist = -1;
+    duplicates=0;
+    growth=0;
+    all = false;
+    runs = 0;
+    m_files = 0;
+
+    std::string tmpl = dir + "/spider-search-XXXXXX";
+    std::vector<char> name(tmpl.begin(),tmpl.end());
+    name.push_back(0);
+    if (mkdtemp(name.data()) == 0) throw std::runtime_error("could not create a directory in " + dir);
+    m_prefix = name.data();
+
+    uint8_t key[DeckCodec::MAX_BYTES];
+    for (int side=0; side<2; ++side) {
+      std::string level = tempName();
+      KeyWriter out(level,codec.bytes());
+      codec.encode(side == 0 ? from : to,key);
+      out.write(key);
+      out.close();
+      (side == 0 ? m_forward : m_reverse).push_back(level);
+      (side == 0 ? forward : reverse).push_back(1);
+    }
+  }
+
+  SearchDisk::~SearchDisk() {
+    for (auto &level : m_forward) remove(level.c_str());
+    for (auto &level : m_reverse) remove(level.c_str());
+    rmdir(m_prefix.c_str());
+  }
+
+  std::string SearchDisk::tempName() {
+    return m_prefix + "/" + std::to_string(m_files++);
+  }
+
+  void SearchDisk::grow() {
+    if (dist % 2 == 0) {
+      growForward();
+    } else {
+      growReverse();
+    }
+  }
+
+  bool SearchDisk::done() const {
+    if (!all && paths.size() > 0) return true;
+    if (maxDist >= 0 && dist >= maxDist) return true;
+    return false;
+  }
+
+  bool SearchDisk::found() const {
+    return paths.size() > 0;
+  }
+
+  void SearchDisk::find() {
+    while (!done()) {
+      grow();
+    }
+  }
+
+  void SearchDisk::growForward() {
+    growSide(true);
+  }
+
+  void SearchDisk::growReverse() {
+    growSide(false);
+  }
+
+  uint64_t SearchDisk::bytesOnDisk() const {
+    uint64_t ans = 0;
+    for (auto &level : m_forward) ans += fileBytes(level);
+    for (auto &level : m_reverse) ans += fileBytes(level);
+    return ans;
+  }
+
+  std::vector<std::string> SearchDisk::expand(bool isForward, uint64_t &children) {
+    size_t width = codec.bytes();
+    // half the budget sorts, the rest reads and writes
+    size_t capacity = std::max(size_t(cards),(memory/2)/(width+sizeof(uint8_t*)));
+    std::vector<uint8_t> buffer(capacity*width);
+    std::vector<const uint8_t*> sorted;
+    sorted.reserve(capacity);
+    std::vector<std::string> ans;
+    size_t used = 0;
+
+    auto flush = [&]() {
+      if (used == 0) return;
+      sorted.clear();
+      for (size_t i=0; i<used; ++i) sorted.push_back(&buffer[i*width]);
+      std::sort(sorted.begin(),sorted.end(),[width](const uint8_t *a, const uint8_t *b) {
+	  return memcmp(a,b,width) < 0;
+	});
+      ans.push_back(tempName());
+      KeyWriter out(ans.back(),width);
+      for (size_t i=0; i<used; ++i) {
+	if (i == 0 || memcmp(sorted[i-1],sorted[i],width) != 0) out.write(sorted[i]);
+      }
+      out.close();
+      ++runs;
+      used = 0;
+    };
+
+    children = 0;
+    KeyReader frontier(isForward ? m_forward.back() : m_reverse.back(),width);
+    for (; frontier.ok; frontier.next()) {
+      Deck deck = codec.decode(frontier.key.data());
+      deck.bind(&config);
+      deck.index();
+      for (int order = 0; order < cards; ++order) {
+	Deck newDeck(deck);
+	if (isForward) {
+	  newDeck.mix(Card(order));
+	} else {
+	  newDeck.unmix(Card(order));
+	}
+	if (used == capacity) flush();
+	codec.encode(newDeck,&buffer[used*width]);
+	++used;
+	++children;
+      }
+    }
+    flush();
+    return ans;
+  }
+
+  std::vector<std::string> SearchDisk::reduce(std::vector<std::string> runs) {
+    // readers the budget holds at once, less the visited levels and
+    // the other frontier the last pass reads beside them
+    size_t levels = m_forward.size() + m_reverse.size() + 2;
+    size_t readers = memory/2/FILE_BUFFER;
+    size_t fanIn = readers > levels + 2 ? readers - levels : 2;
+    size_t width = codec.bytes();
+
+    while (runs.size() > fanIn) {
+      std::vector<std::string> merged;
+      for (size_t at=0; at<runs.size(); at += fanIn) {
+	std::vector<std::string> group(runs.begin()+at,runs.begin()+std::min(at+fanIn,runs.size()));
+	if (group.size() == 1) {
+	  merged.push_back(group[0]);
+	  continue;
+	}
+	merged.push_back(tempName());
+	{
+	  KeyMerge merge(group,width);
+	  KeyWriter out(merged.back(),width);
+	  while (merge.next()) out.write(merge.key.data());
+	  out.close();
+	}
+	for (auto &run : group) remove(run.c_str());
+	++this->runs;
+      }
+      runs.swap(merged);
+    }
+    return runs;
+  }
+
+  void SearchDisk::growSide(bool isForward) {
+    size_t width = codec.bytes();
+    uint64_t children = 0;
+    std::vector<std::string> runs = reduce(expand(isForward,children));
+
+    std::vector<std::string> &mine = isForward ? m_forward : m_reverse;
+    std::vector<std::string> &theirs = isForward ? m_reverse : m_forward;
+
+    // one pass: merge the runs, join them with the other frontier and
+    // drop what this side has visited
+    std::string level = tempName();
+    std::vector<uint8_t> meets;
+    uint64_t added = 0;
+    {
+      KeyMerge merge(runs,width);
+      KeyReader other(theirs.back(),width);
+      std::vector< std::unique_ptr<KeyReader> > visited;
+      for (auto &was : mine) {
+	visited.push_back(std::unique_ptr<KeyReader>(new KeyReader(was,width)));
+      }
+      KeyWriter out(level,width);
+      while (merge.next()) {
+	const uint8_t *key = merge.key.data();
+	if (other.seek(key)) {
+	  meets.insert(meets.end(),key,key+width);
+	  continue;
+	}
+	bool seen = false;
+	for (auto &reader : visited) {
+	  if (reader->seek(key)) seen = true;
+	}
+	if (seen) continue;
+	out.write(key);
+	++added;
+      }
+      out.close();
+    }
+    for (auto &run : runs) remove(run.c_str());
+
+    duplicates += children - added - meets.size()/width;
+    if (meets.size() > 0) {
+      pathsTo(isForward,meets);
+      if (!all) {
+	remove(level.c_str());
+	return;
+      }
+    }
+
+    uint64_t was = isForward ? forward.back() : reverse.back();
+    growth = double(added)/double(was);
+    mine.push_back(level);
+    (isForward ? forward : reverse).push_back(added);
+    ++dist;
+  }
+
+  // every edge from the frontier just grown into a meeting state
+  void SearchDisk::pathsTo(bool isForward, const std::vector<uint8_t> &meets) {
+    size_t width = codec.bytes();
+    size_t count = meets.size()/width;
+    int flevel = m_forward.size()-1;
+    int rlevel = m_reverse.size()-1;
+    uint8_t key[DeckCodec::MAX_BYTES];
+
+    KeyReader frontier(isForward ? m_forward.back() : m_reverse.back(),width);
+    for (; frontier.ok; frontier.next()) {
+      Deck deck = codec.decode(frontier.key.data());
+      deck.bind(&config);
+      deck.index();
+      for (int order = 0; order < cards; ++order) {
+	Card card(order);
+	Deck newDeck(deck);
+	if (isForward) {
+	  newDeck.mix(card);
+	} else {
+	  newDeck.unmix(card);
+	}
+	codec.encode(newDeck,key);
+	size_t lo = 0, hi = count;
+	while (lo < hi) {
+	  size_t mid = (lo+hi)/2;
+	  if (memcmp(&meets[mid*width],key,width) < 0) lo = mid+1; else hi = mid;
+	}
+	if (lo == count || memcmp(&meets[lo*width],key,width) != 0) continue;
+
+	std::vector<Card> path = forwardPath(isForward ? deck : newDeck,flevel);
+	path.push_back(card);
+	std::vector<Card> rest = reversePath(isForward ? newDeck : deck,rlevel);
+	path.insert(path.end(),rest.begin(),rest.end());
+	paths.push_back(path);
+	if (!all) return;
+      }
+    }
+  }
+
+  // cards from `from` to deck, a state of forward level
+  std::vector<Card> SearchDisk::forwardPath(Deck deck, int level) {
+    size_t width = codec.bytes();
+    std::vector<Card> ans;
+    uint8_t key[DeckCodec::MAX_BYTES], back[DeckCodec::MAX_BYTES];
+    for (int k=level; k>0; --k) {
+      codec.encode(deck,key);
+      bool stepped = false;
+      // unmix guesses the predecessor; mix has the last word
+      for (int order = 0; order < cards && !stepped; ++order) {
+	Card card(order);
+	Deck prev(deck);
+	prev.unmix(card);
+	codec.encode(prev,back);
+	if (!contains(m_forward[k-1],back)) continue;
+	Deck check(prev);
+	check.mix(card);
+	codec.encode(check,back);
+	if (memcmp(back,key,width) != 0) continue;
+	ans.push_back(card);
+	deck = prev;
+	stepped = true;
+      }
+      // else scan the level below for an edge into deck
+      KeyReader below(m_forward[k-1],width);
+      for (; !stepped && below.ok; below.next()) {
+	Deck prev = codec.decode(below.key.data());
+	prev.bind(&config);
+	prev.index();
+	for (int order = 0; order < cards && !stepped; ++order) {
+	  Card card(order);
+	  Deck check(prev);
+	  check.mix(card);
+	  codec.encode(check,back);
+	  if (memcmp(back,key,width) != 0) continue;
+	  ans.push_back(card);
+	  deck = prev;
+	  stepped = true;
+	}
+      }
+      if (!stepped) throw std::runtime_error("no edge into forward level " + std::to_string(k));
+    }
+    std::reverse(ans.begin(),ans.end());
+    return ans;
+  }
+
+  // cards from deck, a state of reverse level, to `to`
+  std::vector<Card> SearchDisk::reversePath(Deck deck, int level) {
+    std::vector<Card> ans;
+    uint8_t key[DeckCodec::MAX_BYTES];
+    for (int k=level; k>0; --k) {
+      bool stepped = false;
+      for (int order = 0; order < cards && !stepped; ++order) {
+	Card card(order);
+	Deck next(deck);
+	next.mix(card);
+	codec.encode(next,key);
+	if (!contains(m_reverse[k-1],key)) continue;
+	ans.push_back(card);
+	deck = next;
+	stepped = true;
+      }
+      if (!stepped) throw std::runtime_error("no edge out of reverse level " + std::to_string(k));
+    }
+    return ans;
+  }
+
+  // binary search of a level file
+  bool SearchDisk::contains(const std::string &level, const uint8_t *key) {
+    size_t width = codec.bytes();
+    FILE *file = fopen(level.c_str(),"rb");
+    if (file == 0) throw std::runtime_error("could not open " + level);
+    uint8_t at[DeckCodec::MAX_BYTES];
+    uint64_t lo = 0, hi = fileBytes(level)/width;
+    bool ans = false;
+    while (lo < hi) {
+      uint64_t mid = (lo+hi)/2;
+      if (fseeko(file,off_t(mid*width),SEEK_SET) != 0 || fread(at,width,1,file) != 1) {
+	fclose(file);
+	throw std::runtime_error("could not read " + level);
+      }
+      int cmp = memcmp(at,key,width);
+      if (cmp == 0) {
+	ans = true;
+	break;
+      }
+      if (cmp < 0) lo = mid+1; else hi = mid;
+    }
+    fclose(file);
+    return ans;
+  }
+}
@@ -0,0 +1,388 @@
+#include <string.h>
+#include <cassert>
+#include <utility>
+#include <thread>
+
+#include "search_set.h"
+
+namespace spider {
+
+  namespace {
+    // chunk k of the arena holds FIRST_RECORDS << k records
+    const size_t FIRST_RECORDS = 64;
+
+    inline int chunkOf(size_t record) {
+      return 63 - __builtin_clzll(record/FIRST_RECORDS + 1);
+    }
+
+    inline size_t chunkBase(int chunk) {
+      return FIRST_RECORDS*((size_t(1) << chunk) - 1);
+    }
+  }
+
+  const size_t SearchSet::MAX_RECORD_BYTES;
+
+  SearchSet::SearchSet(DeckCodec::Format format, bool linked, bool rotate) : m_format(format), m_codec(1,format,rotate), m_linked(linked), m_rotate(rotate), m_cards(0), m_indexed(false), m_bound(0), m_keyBytes(0), m_recordBytes(0), m_size(0), m_mask(0) {}
+
+  SearchSet::SearchSet(const SearchSet &copy) : SearchSet(copy.m_format,copy.m_linked,copy.m_rotate) {
+    *this = copy;
+  }
+
+  SearchSet::SearchSet(SearchSet &&move) : SearchSet(move.m_format,move.m_linked,move.m_rotate) {
+    swap(move);
+  }
+
+  SearchSet& SearchSet::operator=(const SearchSet &copy) {
+    if (this == &copy) return *this;
+    m_format = copy.m_format;
+    m_codec = copy.m_codec;
+    m_linked = copy.m_linked;
+    m_rotate = copy.m_rotate;
+    m_cards = copy.m_cards;
+    m_indexed = copy.m_indexed;
+    m_bound = copy.m_bound;
+    m_keyBytes = copy.m_keyBytes;
+    m_recordBytes = copy.m_recordBytes;
+    m_chunks.clear();
+    for (size_t k=0; k<copy.m_chunks.size(); ++k) {
+      size_t bytes = (FIRST_RECORDS << k)*m_recordBytes;
+      m_chunks.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[bytes]));
+      memcpy(m_chunks[k].get(),copy.m_chunks[k].get(),bytes);
+    }
+    m_size = copy.m_size;
+    m_slots = copy.m_slots;
+    m_mask = copy.m_mask;
+    m_more = copy.m_more;
+    return *this;
+  }
+
+  SearchSet& SearchSet::operator=(SearchSet &&move) {
+    swap(move);
+    return *this;
+  }
+
+  void SearchSet::clear() {
+    m_cards = 0;
+    m_indexed = false;
+    m_bound = 0;
+    m_keyBytes = 0;
+    m_recordBytes = 0;
+    m_chunks.clear();
+    m_size = 0;
+    m_slots.clear();
+    m_mask = 0;
+    m_more.clear();
+  }
+
+  void SearchSet::swap(SearchSet &with) {
+    std::swap(m_format,with.m_format);
+    std::swap(m_codec,with.m_codec);
+    std::swap(m_linked,with.m_linked);
+    std::swap(m_rotate,with.m_rotate);
+    std::swap(m_cards,with.m_cards);
+    std::swap(m_indexed,with.m_indexed);
+    std::swap(m_bound,with.m_bound);
+    std::swap(m_keyBytes,with.m_keyBytes);
+    std::swap(m_recordBytes,with.m_recordBytes);
+    m_chunks.swap(with.m_chunks);
+    std::swap(m_size,with.m_size);
+    m_slots.swap(with.m_slots);
+    std::swap(m_mask,with.m_mask);
+    m_more.swap(with.m_more);
+  }
+
+  void SearchSet::shape(const Deck &deck) {
+    if (m_cards == 0) {
+      m_cards = deck.cards.size();
+      m_indexed = deck.indexed;
+      m_bound = deck.bound;
+      m_codec = DeckCodec(m_cards,m_format,m_rotate);
+      m_keyBytes = m_codec.bytes();
+      m_recordBytes = 1 + m_keyBytes + (m_linked ? sizeof(uint64_t) : 0);
+      rehash(16);
+    }
+    assert(int(deck.cards.size()) == m_cards);
+  }
+
+  void SearchSet::pack(const Deck &deck, uint8_t *record, uint64_t link) const {
+    record[0] = m_codec.encode(deck,record+1);
+    if (m_linked) memcpy(record+1+m_keyBytes,&link,sizeof(link));
+  }
+
+  uint64_t SearchSet::link(size_t i) const {
+    assert(m_linked && i < m_size);
+    uint64_t ans;
+    memcpy(&ans,record(i)+1+m_keyBytes,sizeof(ans));
+    return ans;
+  }
+
+  void SearchSet::links(size_t i, std::vector<uint64_t> &out) const {
+    out.clear();
+    out.push_back(link(i));
+    auto more = m_more.equal_range(uint32_t(i));
+    for (auto at = more.first; at != more.second; ++at) out.push_back(at->second);
+  }
+
+  void SearchSet::addLink(size_t i, uint64_t link) {
+    assert(m_linked && i < m_size);
+    m_more.insert(std::make_pair(uint32_t(i),link));
+  }
+
+  Deck SearchSet::deck(size_t i) const {
+    assert(i < m_size);
+    const uint8_t *rec = record(i);
+    Deck ans = m_codec.decode(rec+1,rec[0]);
+    ans.bind(m_bound);
+    if (m_indexed) ans.index();
+    return ans;
+  }
+
+  uint8_t* SearchSet::append() {
+    int chunk = chunkOf(m_size);
+    if (chunk >= int(m_chunks.size())) {
+      m_chunks.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[(FIRST_RECORDS << chunk)*m_recordBytes]));
+    }
+    uint8_t *ans = m_chunks[chunk].get() + (m_size-chunkBase(chunk))*m_recordBytes;
+    ++m_size;
+    return ans;
+  }
+
+  const uint8_t* SearchSet::record(size_t i) const {
+    int chunk = chunkOf(i);
+    return m_chunks[chunk].get() + (i-chunkBase(chunk))*m_recordBytes;
+  }
+
+  uint64_t SearchSet::hashKey(const uint8_t *key) const {
+    uint64_t h = m_keyBytes;
+    for (size_t at=0; at<m_keyBytes; at += 8) {
+      uint64_t word = 0;
+      memcpy(&word,key+at,m_keyBytes-at < 8 ? m_keyBytes-at : 8);
+      h = (h ^ word) * 0x9e3779b97f4a7c15ULL;
+      h ^= h >> 29;
+    }
+    // splitmix64 finalizer
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+  }
+
+  size_t SearchSet::probe(const uint8_t *key, uint64_t h) const {
+    uint64_t tag = h >> 32;
+    size_t at = h & m_mask;
+    for (;;) {
+      uint64_t slot = m_slots[at];
+      if (slot == 0) return at;
+      if ((slot >> 32) == tag && memcmp(record(uint32_t(slot)-1)+1,key,m_keyBytes) == 0) return at;
+      at = (at+1) & m_mask;
+    }
+  }
+
+  void SearchSet::rehash(size_t capacity) {
+    std::vector<uint64_t> slots(capacity,0);
+    m_slots.swap(slots);
+    m_mask = capacity-1;
+    for (auto slot : slots) {
+      if (slot == 0) continue;
+      uint64_t h = hashKey(record(uint32_t(slot)-1)+1);
+      m_slots[probe(record(uint32_t(slot)-1)+1,h)] = slot;
+    }
+  }
+
+  bool SearchSet::insertRecord(const uint8_t *rec, uint64_t h) {
+    size_t at = probe(rec+1,h);
+    if (m_slots[at] != 0) return false;
+    // keep the load under 3/4
+    if (4*(m_size+1) > 3*m_slots.size()) {
+      rehash(2*m_slots.size());
+      at = probe(rec+1,h);
+    }
+    assert(m_size < 0xffffffffULL);
+    m_slots[at] = ((h >> 32) << 32) | uint64_t(m_size+1);
+    memcpy(append(),rec,m_recordBytes);
+    return true;
+  }
+
+  bool SearchSet::insert(const Deck &deck) {
+    shape(deck);
+    uint8_t rec[MAX_RECORD_BYTES];
+    pack(deck,rec);
+    return insertRecord(rec,hash(rec));
+  }
+
+  void SearchSet::insert(const_iterator first, const_iterator last) {
+    if (first == last) return;
+    const SearchSet *from = first.set();
+    if (from == this) return;
+    if (from->m_format != m_format || from->m_linked != m_linked || from->m_rotate != m_rotate) {
+      for (; first != last; ++first) insert(*first);
+      return;
+    }
+    shape(from->deck(first.record()));
+    assert(from->m_cards == m_cards && from->m_recordBytes == m_recordBytes);
+    for (size_t i=first.record(); i<last.record(); ++i) {
+      const uint8_t *rec = from->record(i);
+      if (!insertRecord(rec,hash(rec)) || from->m_more.empty()) continue;
+      auto more = from->m_more.equal_range(uint32_t(i));
+      for (auto at = more.first; at != more.second; ++at) addLink(m_size-1,at->second);
+    }
+  }
+
+  SearchSet::const_iterator SearchSet::find(const Deck &deck) const {
+    if (m_size == 0 || int(deck.cards.size()) != m_cards) return end();
+    uint8_t rec[MAX_RECORD_BYTES];
+    pack(deck,rec);
+    return findRecord(rec,hash(rec));
+  }
+
+  SearchSet::const_iterator SearchSet::findRecord(const uint8_t *rec, uint64_t h) const {
+    if (m_size == 0) return end();
+    uint64_t slot = m_slots[probe(rec+1,h)];
+    return slot != 0 ? const_iterator(this,uint32_t(slot)-1) : end();
+  }
+
+  namespace {
+    template <typename T>
+    bool put(FILE *file, const T &value) {
+      return fwrite(&value,sizeof(value),1,file) == 1;
+    }
+
+    template <typename T>
+    bool get(FILE *file, T &value) {
+      return fread(&value,sizeof(value),1,file) == 1;
+    }
+  }
+
+  // format, linked, rotate, cards, size, the records chunk by chunk,
+  // then the extra links
+  bool SearchSet::write(FILE *file) const {
+    bool ok = put(file,uint8_t(m_format)) && put(file,uint8_t(m_linked)) && put(file,uint8_t(m_rotate));
+    ok = ok && put(file,int32_t(m_cards)) && put(file,uint64_t(m_size));
+    for (size_t k=0; ok && k<m_chunks.size(); ++k) {
+      size_t records = m_size-chunkBase(k);
+      if (records > (FIRST_RECORDS << k)) records = FIRST_RECORDS << k;
+      ok = fwrite(m_chunks[k].get(),m_recordBytes,records,file) == records;
+    }
+    ok = ok && put(file,uint64_t(m_more.size()));
+    for (auto at = m_more.begin(); ok && at != m_more.end(); ++at) {
+      ok = put(file,at->first) && put(file,at->second);
+    }
+    return ok;
+  }
+
+  bool SearchSet::read(FILE *file, const Deck &like) {
+    clear();
+    uint8_t format, linked, rotate;
+    int32_t cards;
+    uint64_t size, more;
+    if (!get(file,format) || !get(file,linked) || !get(file,rotate) || !get(file,cards) || !get(file,size)) return false;
+    if (format != m_format || bool(linked) != m_linked || bool(rotate) != m_rotate) return false;
+    if (size > 0) {
+      if (cards != int(like.cards.size())) return false;
+      shape(like);
+      size_t capacity = 16;
+      while (4*(size+1) > 3*capacity) capacity *= 2;
+      rehash(capacity);
+      uint8_t rec[MAX_RECORD_BYTES];
+      for (uint64_t i=0; i<size; ++i) {
+	if (fread(rec,m_recordBytes,1,file) != 1) return false;
+	if (!insertRecord(rec,hash(rec))) return false;
+      }
+    }
+    if (!get(file,more)) return false;
+    for (uint64_t i=0; i<more; ++i) {
+      uint32_t record;
+      uint64_t link;
+      if (!get(file,record) || !get(file,link) || record >= m_size) return false;
+      addLink(record,link);
+    }
+    return true;
+  }
+
+  size_t SearchSet::bytes() const {
+    size_t ans = m_slots.capacity()*sizeof(uint64_t);
+    // a guess at the node of each extra link
+    ans += m_more.size()*(sizeof(uint32_t)+sizeof(uint64_t)+2*sizeof(void*));
+    for (size_t k=0; k<m_chunks.size(); ++k) {
+      ans += (FIRST_RECORDS << k)*m_recordBytes;
+    }
+    return ans;
+  }
+
+  const int SearchShards::SHARDS;
+
+  SearchShards::SearchShards(DeckCodec::Format format, bool linked) : m_shards(SHARDS,SearchSet(format,linked)) {}
+
+  size_t SearchShards::size() const {
+    size_t ans = 0;
+    for (auto &shard : m_shards) ans += shard.size();
+    return ans;
+  }
+
+  void SearchShards::clear() {
+    for (auto &shard : m_shards) shard.clear();
+  }
+
+  void SearchShards::swap(SearchShards &with) {
+    m_shards.swap(with.m_shards);
+  }
+
+  void SearchShards::shape(const Deck &deck) {
+    for (auto &shard : m_shards) shard.shape(deck);
+  }
+
+  bool SearchShards::insert(const Deck &deck) {
+    shape(deck);
+    uint8_t rec[SearchSet::MAX_RECORD_BYTES];
+    pack(deck,rec);
+    uint64_t h = hash(rec);
+    return m_shards[shardOf(h)].insertRecord(rec,h);
+  }
+
+  void SearchShards::insert(const SearchShards &from, int threads) {
+    if (this == &from || from.empty()) return;
+    shape(*from.begin());
+    auto work = [&](int first) {
+      for (int i=first; i<SHARDS; i += threads) {
+	m_shards[i].insert(from.m_shards[i].begin(),from.m_shards[i].end());
+      }
+    };
+    if (threads <= 1) {
+      threads = 1;
+      work(0);
+      return;
+    }
+    std::vector<std::thread> workers;
+    for (int t=0; t<threads; ++t) workers.push_back(std::thread(work,t));
+    for (auto &worker : workers) worker.join();
+  }
+
+  SearchShards::const_iterator SearchShards::find(const Deck &deck) const {
+    if (m_shards[0].cards() != int(deck.cards.size())) return end();
+    uint8_t rec[SearchSet::MAX_RECORD_BYTES];
+    pack(deck,rec);
+    uint64_t h = hash(rec);
+    auto at = m_shards[shardOf(h)].findRecord(rec,h);
+    if (at == m_shards[shardOf(h)].end()) return end();
+    return const_iterator(this,shardOf(h),at.record());
+  }
+
+  size_t SearchShards::bytes() const {
+    size_t ans = 0;
+    for (auto &shard : m_shards) ans += shard.bytes();
+    return ans;
+  }
+
+  bool SearchShards::write(FILE *file) const {
+    for (auto &shard : m_shards) {
+      if (!shard.write(file)) return false;
+    }
+    return true;
+  }
+
+  bool SearchShards::read(FILE *file, const Deck &like) {
+    for (auto &shard : m_shards) {
+      if (!shard.read(file,like)) return false;
+    }
+    return true;
+  }
+}
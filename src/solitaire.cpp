@@ -26,10 +26,7 @@ namespace spider {
   }
   
   void Solitaire::shuffle(RNG &rng) {
-    for (int i=0; i<N; ++i) {
-      int j=rng.next(i,N-1);
-      swap(i,j);
-    }
+    shuffle<RNG>(rng);
   }
 
   void Solitaire::down1(int card) {
@@ -3,7 +3,9 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <limits.h>
+#include <atomic>
 #include "spider_solitare.h"
+#include "rng.h"
 
 #define ADD(x,y) (((x)+(y))%CARDS)
 #define SUB(x,y) (((x)+(CARDS-(y)))%CARDS)
@@ -134,21 +136,28 @@ void CardArrayIOInit(CardArrayIO *me, Card *cards, int step, int size, int capac
   me->writes=0;
 }
 
+static spider::OS_RNG OS_RAND;
+
 static int CardRandIORead(CardIO *me) {
   CardRandIO *my=(CardRandIO *)me;  
   uint8_t x;
   
   do {
-    int status = fread((char*) &x,sizeof(x),1,my->urand);
-    if (status <= 0) return -1;
+    if (my->bytes == 0) {
+      my->word = OS_RAND.next_u32();
+      my->bytes = sizeof(my->word);
+    }
+    x = my->word & 0xFF;
+    my->word >>= 8;
+    --my->bytes;
   } while (x >= (256-256%CARDS));
   return x % CARDS;
 }
 
 static void CardRandIOClose(CardIO *me) {
   CardRandIO *my=(CardRandIO *)me;
-  fclose(my->urand);
-  my->urand=NULL;
+  my->word=0;
+  my->bytes=0;
 }
 
 
@@ -156,8 +165,9 @@ void CardRandIOInit(CardRandIO *me) {
   me->base.read=&CardRandIORead;
   me->base.write=NULL;
   me->base.peek=NULL;
-  me->base.close=&CardArrayIOClose;
-  me->urand=fopen("/dev/urandom","rb");
+  me->base.close=&CardRandIOClose;
+  me->word=0;
+  me->bytes=0;
 }
 
 
@@ -240,27 +250,296 @@ void deckBackFrontShuffle(Deck input, Deck output)
   }
 }
 
-int deckFindCard(Deck deck,Card card)
+static int deckFindCardScalar(Deck deck,Card card)
 {
   return FIND(deck,card);
 }
 
-void deckPseudoShuffle(Deck deck, int cutLoc) {
+static void deckPseudoShuffleScalar(Deck deck, int cutLoc) {
   Deck temp;
   deckCut(deck,cutLoc,temp);
   deckBackFrontShuffle(temp,deck);
 }
 
+static Card deckCipherPadScalar(Deck deck) {
+  Card markCard = MARK_CARD(deck);
+  int markLoc = deckFindCardScalar(deck,markCard);
+  Card cipherPad = deck[ADD(markLoc,1)];
+  return cipherPad;
+}
+
+static int deckKernelAlways(void) {
+  return 1;
+}
+
+const DeckKernelTable DECK_KERNEL_SCALAR = {
+  "scalar",
+  &deckKernelAlways,
+  &deckFindCardScalar,
+  &deckCipherPadScalar,
+  &deckPseudoShuffleScalar
+};
+
+#if CARDS == 40 && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+
+/*
+ * The vector kernels hold the deck in registers as
+ *
+ *   deck[0..15], deck[16..31], deck[32..39] + 8 lanes of 0xFF
+ *
+ * and never index memory by a card or location.  A card is found by
+ * masking a table of locations with a compare and summing the bytes
+ * (only one lane survives), a card at a location is selected the same
+ * way, and the pseudo-shuffle is a byte shuffle whose control is
+ * computed from the cut location with vector arithmetic.
+ */
+
+/* location of each lane, 0xFF never matches a card or location */
+static const uint8_t LOCS[64] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,15,
+  16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,
+  32,33,34,35,36,37,38,39,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255
+};
+
+/* back-front shuffle: output[i]=input[BACK_FRONT[i]], padded to 64 */
+static const uint8_t BACK_FRONT[64] = {
+  39,37,35,33,31,29,27,25,23,21,19,17,15,13,11, 9,
+  7, 5, 3, 1, 0, 2, 4, 6, 8,10,12,14,16,18,20,22,
+  24,26,28,30,32,34,36,38, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+#define SSE4 __attribute__((target("sse4.1")))
+#define AVX2 __attribute__((target("avx2")))
+
+SSE4 static inline __m128i load128(const void *p) {
+  return _mm_loadu_si128((const __m128i*) p);
+}
+
+/* deck[32..39] and 8 lanes that match nothing */
+SSE4 static inline __m128i loadTail128(Deck deck) {
+  return _mm_or_si128(_mm_loadl_epi64((const __m128i*) (deck+32)),
+		      _mm_slli_si128(_mm_set1_epi8(-1),8));
+}
+
+SSE4 static inline int sumBytes128(__m128i v) {
+  __m128i sums = _mm_sad_epu8(v,_mm_setzero_si128());
+  return _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums,4);
+}
+
+SSE4 static int deckFindCardSSE4(Deck deck, Card card) {
+  __m128i c = _mm_set1_epi8(card);
+  __m128i at0 = _mm_and_si128(_mm_cmpeq_epi8(load128(deck),c),load128(LOCS));
+  __m128i at1 = _mm_and_si128(_mm_cmpeq_epi8(load128(deck+16),c),load128(LOCS+16));
+  __m128i at2 = _mm_and_si128(_mm_cmpeq_epi8(loadTail128(deck),c),load128(LOCS+32));
+  return sumBytes128(_mm_or_si128(_mm_or_si128(at0,at1),at2));
+}
+
+SSE4 static Card deckCipherPadSSE4(Deck deck) {
+  Card markCard = MARK_CARD(deck);
+  int markLoc = deckFindCardSSE4(deck,markCard);
+  __m128i padLoc = _mm_set1_epi8(ADD(markLoc,1));
+  __m128i pad0 = _mm_and_si128(_mm_cmpeq_epi8(load128(LOCS),padLoc),load128(deck));
+  __m128i pad1 = _mm_and_si128(_mm_cmpeq_epi8(load128(LOCS+16),padLoc),load128(deck+16));
+  __m128i pad2 = _mm_and_si128(_mm_cmpeq_epi8(load128(LOCS+32),padLoc),loadTail128(deck));
+  return sumBytes128(_mm_or_si128(_mm_or_si128(pad0,pad1),pad2));
+}
+
+/* shuffle control for source lanes [base,base+16) of the locations
+   in locs, lanes outside the source get the zeroing high bit */
+SSE4 static inline __m128i shuffleControl128(__m128i locs, int base) {
+  __m128i local = _mm_sub_epi8(locs,_mm_set1_epi8(base));
+  __m128i inside = _mm_and_si128(_mm_cmpgt_epi8(local,_mm_set1_epi8(-1)),
+				 _mm_cmpgt_epi8(_mm_set1_epi8(16),local));
+  return _mm_or_si128(local,_mm_andnot_si128(inside,_mm_set1_epi8(-128)));
+}
+
+/* cards at (BACK_FRONT[i]+cutLoc) % CARDS for 16 output lanes */
+SSE4 static inline __m128i gather128(__m128i d0, __m128i d1, __m128i d2,
+				     __m128i cut, const uint8_t *backFront) {
+  __m128i locs = _mm_add_epi8(load128(backFront),cut);
+  locs = _mm_sub_epi8(locs,_mm_and_si128(_mm_cmpgt_epi8(locs,_mm_set1_epi8(CARDS-1)),
+					 _mm_set1_epi8(CARDS)));
+  return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(d0,shuffleControl128(locs,0)),
+				   _mm_shuffle_epi8(d1,shuffleControl128(locs,16))),
+		      _mm_shuffle_epi8(d2,shuffleControl128(locs,32)));
+}
+
+SSE4 static void deckPseudoShuffleSSE4(Deck deck, int cutLoc) {
+  __m128i d0 = load128(deck);
+  __m128i d1 = load128(deck+16);
+  __m128i d2 = loadTail128(deck);
+  __m128i cut = _mm_set1_epi8(cutLoc);
+  __m128i out0 = gather128(d0,d1,d2,cut,BACK_FRONT);
+  __m128i out1 = gather128(d0,d1,d2,cut,BACK_FRONT+16);
+  __m128i out2 = gather128(d0,d1,d2,cut,BACK_FRONT+32);
+  _mm_storeu_si128((__m128i*) deck,out0);
+  _mm_storeu_si128((__m128i*) (deck+16),out1);
+  _mm_storel_epi64((__m128i*) (deck+32),out2);
+}
+
+AVX2 static inline __m256i load256(const void *p) {
+  return _mm256_loadu_si256((const __m256i*) p);
+}
+
+/* deck[32..39] and 24 lanes that match nothing */
+AVX2 static inline __m256i loadTail256(Deck deck) {
+  __m128i tail = _mm_or_si128(_mm_loadl_epi64((const __m128i*) (deck+32)),
+			      _mm_slli_si128(_mm_set1_epi8(-1),8));
+  return _mm256_inserti128_si256(_mm256_set1_epi8(-1),tail,0);
+}
+
+AVX2 static inline int sumBytes256(__m256i v) {
+  __m256i sums = _mm256_sad_epu8(v,_mm256_setzero_si256());
+  __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums),
+			       _mm256_extracti128_si256(sums,1));
+  return _mm_cvtsi128_si32(half) + _mm_extract_epi16(half,4);
+}
+
+AVX2 static int deckFindCardAVX2(Deck deck, Card card) {
+  __m256i c = _mm256_set1_epi8(card);
+  __m256i at0 = _mm256_and_si256(_mm256_cmpeq_epi8(load256(deck),c),load256(LOCS));
+  __m256i at1 = _mm256_and_si256(_mm256_cmpeq_epi8(loadTail256(deck),c),load256(LOCS+32));
+  return sumBytes256(_mm256_or_si256(at0,at1));
+}
+
+AVX2 static Card deckCipherPadAVX2(Deck deck) {
+  Card markCard = MARK_CARD(deck);
+  int markLoc = deckFindCardAVX2(deck,markCard);
+  __m256i padLoc = _mm256_set1_epi8(ADD(markLoc,1));
+  __m256i pad0 = _mm256_and_si256(_mm256_cmpeq_epi8(load256(LOCS),padLoc),load256(deck));
+  __m256i pad1 = _mm256_and_si256(_mm256_cmpeq_epi8(load256(LOCS+32),padLoc),loadTail256(deck));
+  return sumBytes256(_mm256_or_si256(pad0,pad1));
+}
+
+AVX2 static inline __m256i shuffleControl256(__m256i locs, int base) {
+  __m256i local = _mm256_sub_epi8(locs,_mm256_set1_epi8(base));
+  __m256i inside = _mm256_and_si256(_mm256_cmpgt_epi8(local,_mm256_set1_epi8(-1)),
+				    _mm256_cmpgt_epi8(_mm256_set1_epi8(16),local));
+  return _mm256_or_si256(local,_mm256_andnot_si256(inside,_mm256_set1_epi8(-128)));
+}
+
+/* same as gather128 for 32 output lanes, the byte shuffle works within
+   each 128 bit half so every source is broadcast to both halves */
+AVX2 static inline __m256i gather256(__m256i d0, __m256i d1, __m256i d2,
+				     __m256i cut, const uint8_t *backFront) {
+  __m256i locs = _mm256_add_epi8(load256(backFront),cut);
+  locs = _mm256_sub_epi8(locs,_mm256_and_si256(_mm256_cmpgt_epi8(locs,_mm256_set1_epi8(CARDS-1)),
+					       _mm256_set1_epi8(CARDS)));
+  return _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(d0,shuffleControl256(locs,0)),
+					 _mm256_shuffle_epi8(d1,shuffleControl256(locs,16))),
+			 _mm256_shuffle_epi8(d2,shuffleControl256(locs,32)));
+}
+
+AVX2 static void deckPseudoShuffleAVX2(Deck deck, int cutLoc) {
+  __m256i d0 = _mm256_broadcastsi128_si256(load128(deck));
+  __m256i d1 = _mm256_broadcastsi128_si256(load128(deck+16));
+  __m256i d2 = _mm256_broadcastsi128_si256(_mm256_castsi256_si128(loadTail256(deck)));
+  __m256i cut = _mm256_set1_epi8(cutLoc);
+  __m256i out0 = gather256(d0,d1,d2,cut,BACK_FRONT);
+  __m256i out1 = gather256(d0,d1,d2,cut,BACK_FRONT+32);
+  _mm256_storeu_si256((__m256i*) deck,out0);
+  _mm_storel_epi64((__m128i*) (deck+32),_mm256_castsi256_si128(out1));
+}
+
+static int deckKernelSSE4(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.1");
+}
+
+static int deckKernelAVX2(void) {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+const DeckKernelTable DECK_KERNEL_SSE4 = {
+  "sse4",
+  &deckKernelSSE4,
+  &deckFindCardSSE4,
+  &deckCipherPadSSE4,
+  &deckPseudoShuffleSSE4
+};
+
+const DeckKernelTable DECK_KERNEL_AVX2 = {
+  "avx2",
+  &deckKernelAVX2,
+  &deckFindCardAVX2,
+  &deckCipherPadAVX2,
+  &deckPseudoShuffleAVX2
+};
+
+#else
+
+static int deckKernelNever(void) {
+  return 0;
+}
+
+const DeckKernelTable DECK_KERNEL_SSE4 = {
+  "sse4",
+  &deckKernelNever,
+  &deckFindCardScalar,
+  &deckCipherPadScalar,
+  &deckPseudoShuffleScalar
+};
+
+const DeckKernelTable DECK_KERNEL_AVX2 = {
+  "avx2",
+  &deckKernelNever,
+  &deckFindCardScalar,
+  &deckCipherPadScalar,
+  &deckPseudoShuffleScalar
+};
+
+#endif
+
+/* NULL until deckUseKernel picks one; atomic so any thread may ask */
+static std::atomic<const DeckKernelTable*> currentDeckKernel(NULL);
+
+static const DeckKernelTable *bestDeckKernel(void) {
+  const DeckKernelTable *best[] = { &DECK_KERNEL_AVX2, &DECK_KERNEL_SSE4, &DECK_KERNEL_SCALAR };
+  for (int i=0; ; ++i) {
+    if (best[i]->supported()) {
+      return best[i];
+    }
+  }
+}
+
+const DeckKernelTable *deckKernel(void) {
+  const DeckKernelTable *kernel = currentDeckKernel.load();
+  if (kernel == NULL) {
+    /* initialized once, whichever thread gets here first */
+    static const DeckKernelTable *best = bestDeckKernel();
+    kernel = best;
+  }
+  return kernel;
+}
+
+int deckUseKernel(const DeckKernelTable *kernel) {
+  if (!kernel->supported()) {
+    return -1;
+  }
+  currentDeckKernel.store(kernel);
+  return 0;
+}
+
+int deckFindCard(Deck deck,Card card)
+{
+  return deckKernel()->findCard(deck,card);
+}
+
+void deckPseudoShuffle(Deck deck, int cutLoc) {
+  deckKernel()->pseudoShuffle(deck,cutLoc);
+}
+
 Card deckCutPad(Deck deck) {
   Card cutPad=deck[CUT_ZTH];
   return cutPad;
 }
 
 Card deckCipherPad(Deck deck) {
-  Card markCard = MARK_CARD(deck);
-  int markLoc = deckFindCard(deck,markCard);
-  Card cipherPad = deck[ADD(markLoc,1)];
-  return cipherPad;
+  return deckKernel()->cipherPad(deck);
 }
 
 void deckAdvance(Deck deck, Card inputCard, Card *outputCard, int mode) {
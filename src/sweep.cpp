@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+#include "sweep.h"
+
+namespace spider {
+
+  std::string SweepItem::key() const {
+    std::ostringstream oss;
+    oss << n << "," << cfg.cipherZth << "," << cfg.cipherOffset << "," << cfg.cutZth << "," << cfg.cutOffset;
+    return oss.str();
+  }
+
+  Sweep::Sweep() : shard(0), shards(1), path("sweep.csv"), seed(0), zTrials(10*10), tTrials(100*100), messageLen(-1), threads(std::max(1u,std::thread::hardware_concurrency())), batch(true), sprtAlpha(0), sprtDelta(1.0) {}
+
+  std::string Sweep::header() {
+    std::ostringstream oss;
+    DeckStats stats(40,RNG::DEFAULT,oss);
+    stats.outHeader();
+    std::string ans = oss.str();
+    return ans.substr(0,ans.find('\n'));
+  }
+
+  std::vector<SweepItem> Sweep::items() const {
+    std::vector<SweepItem> ans;
+    int index = 0;
+    for (auto n : ns) {
+      for (auto cfg : cfgs) {
+	if (index++ % shards != shard) continue;
+	SweepItem item;
+	item.n = n;
+	item.cfg = cfg;
+	ans.push_back(item);
+      }
+    }
+    return ans;
+  }
+
+  uint64_t Sweep::itemSeed(const SweepItem &item) const {
+    uint64_t ans = seed;
+    for (int64_t value : {item.n, item.cfg.cipherZth, item.cfg.cipherOffset, item.cfg.cutZth, item.cfg.cutOffset}) {
+      SPLITMIX_RNG mix(ans ^ uint64_t(value));
+      ans = mix.next_u64();
+    }
+    return ans;
+  }
+
+  std::string Sweep::settings() const {
+    std::ostringstream oss;
+    oss.precision(std::numeric_limits<double>::max_digits10);
+    oss << "# zTrials=" << zTrials << ",tTrials=" << tTrials << ",messageLen=" << messageLen
+	<< ",seed=" << seed << ",sprtAlpha=" << sprtAlpha << ",sprtDelta=" << sprtDelta;
+    return oss.str();
+  }
+
+  int Sweep::resume() {
+    done.clear();
+    std::ifstream in(path.c_str());
+    if (!in) return 0;
+
+    std::vector<std::string> preamble = { settings(), header() };
+    int fields = std::count(preamble[1].begin(),preamble[1].end(),',')+1;
+
+    // a row is complete once its newline is written, so a crash can
+    // only tear the last line; anything else is not this sweep's file
+    std::string contents((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+    in.close();
+    size_t complete = contents.rfind('\n');
+    complete = (complete == std::string::npos) ? 0 : complete+1;
+    bool torn = complete < contents.size();
+
+    std::istringstream lines(contents.substr(0,complete));
+    std::string line;
+    size_t lineNo = 0;
+    while (getline(lines,line)) {
+      if (lineNo < preamble.size()) {
+	if (line != preamble[lineNo]) {
+	  if (lineNo == 0 && line.compare(0,2,"# ") == 0) {
+	    throw std::runtime_error(path + " was run with other settings: " + line);
+	  }
+	  throw std::runtime_error(path + ":" + std::to_string(lineNo+1) + ": not a sweep header: " + line);
+	}
+      } else {
+	if (std::count(line.begin(),line.end(),',')+1 != fields) {
+	  throw std::runtime_error(path + ":" + std::to_string(lineNo+1) + ": bad row: " + line);
+	}
+	size_t keyEnd = 0;
+	for (int i=0; i<5; ++i) keyEnd = line.find(',',keyEnd)+1;
+	done.insert(line.substr(0,keyEnd-1));
+      }
+      ++lineNo;
+    }
+
+    if (torn && lineNo < preamble.size()) {
+      std::string tail = contents.substr(complete);
+      if (preamble[lineNo].compare(0,tail.size(),tail) != 0) {
+	throw std::runtime_error(path + ":" + std::to_string(lineNo+1) + ": not a sweep header: " + tail);
+      }
+    }
+
+    // drop the torn line, and a torn preamble with it so run() rewrites it
+    if (torn || (lineNo > 0 && lineNo < preamble.size())) {
+      std::string kept = lineNo < preamble.size() ? "" : contents.substr(0,complete);
+      std::string tmp = path + ".tmp";
+      {
+	std::ofstream out(tmp.c_str(),std::ios::trunc);
+	out << kept;
+	if (!out.flush()) throw std::runtime_error("could not write " + tmp);
+      }
+      if (rename(tmp.c_str(),path.c_str()) != 0) {
+	throw std::runtime_error("could not replace " + path);
+      }
+    }
+    return done.size();
+  }
+
+  int Sweep::run(std::ostream &log) {
+    std::vector<SweepItem> todo;
+    for (auto &item : items()) {
+      if (done.count(item.key()) == 0) todo.push_back(item);
+    }
+
+    FILE *out = fopen(path.c_str(),"a");
+    if (out == 0) throw std::runtime_error("could not open " + path);
+    fseek(out,0,SEEK_END);
+    if (ftell(out) == 0) {
+      std::string preamble = settings() + "\n" + header() + "\n";
+      if (fwrite(preamble.data(),1,preamble.size(),out) != preamble.size() || fflush(out) != 0) {
+	fclose(out);
+	throw std::runtime_error("could not write " + path);
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int rows = 0;
+    for (auto &item : todo) {
+      SPLITMIX_RNG rng(itemSeed(item));
+      std::ostringstream row;
+      DeckStats stats(item.n,rng,row);
+      stats.cfg = item.cfg;
+      stats.zTrials = zTrials;
+      stats.tTrials = tTrials;
+      stats.messageLen = messageLen;
+      stats.threads = threads;
+      stats.batch = batch;
+      stats.sprtAlpha = sprtAlpha;
+      stats.sprtDelta = sprtDelta;
+      stats.id = 1;  // no header
+      stats.row();
+
+      // the whole row in one write, on disk before it counts as done
+      std::string line = row.str();
+      if (fwrite(line.data(),1,line.size(),out) != line.size() || fflush(out) != 0 || fsync(fileno(out)) != 0) {
+	fclose(out);
+	throw std::runtime_error("could not write " + path);
+      }
+      done.insert(item.key());
+      ++rows;
+
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      log << "shard " << shard << "/" << shards << ": " << rows << "/" << todo.size()
+	  << " rows (" << item.key() << ") " << secs/rows*(todo.size()-rows) << "s left" << std::endl;
+    }
+    if (fclose(out) != 0) throw std::runtime_error("could not close " + path);
+    return rows;
+  }
+}
@@ -0,0 +1,307 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <math.h>
+#include <cassert>
+#include "gtest/gtest.h"
+#include "rng.h"
+#include "deck.h"
+#include "deck_batch.h"
+#include "deck_kernel.h"
+#include "deck_codec.h"
+#include "histogram.h"
+
+using namespace std;
+using namespace spider;
+
+//
+// Throughput measurements for the deck kernels.  These print rates
+// rather than assert them, the numbers only mean something relative
+// to each other on the same machine.
+//
+
+struct Timer {
+  std::chrono::steady_clock::time_point start;
+  Timer() : start(std::chrono::steady_clock::now()) {}
+  double seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  }
+};
+
+// the pseudo-shuffle as it was before the fused kernel: cut into a
+// heap allocated temp, then back-front shuffle back into the deck.
+void referencePseudoShuffle(Deck &deck, const Card &cutCard) {
+  std::vector<Card> temp(deck.cards.size());
+  int cutLoc = deck.find(cutCard);
+  assert(cutLoc >= 0);
+  Deck::cut(deck.cards,cutLoc,temp);
+  Deck::backFrontShuffle(temp,deck.cards);
+  Deck::forward(deck.cards,0,0);
+}
+
+void referenceMix(Deck &deck, const Card &plain) {
+  referencePseudoShuffle(deck,deck.addMod(deck.cutPad(),plain));
+}
+
+TEST(Bench,Mix) {
+  const int mixes = 1000*1000;
+  for (auto n : {10, 40, 41, 52, 54}) {
+    Deck before(n),after(n);
+    int m = before.modulus();
+
+    Timer beforeTimer;
+    for (int i=0; i<mixes; ++i) {
+      referenceMix(before,Card(i % m));
+    }
+    double beforeRate = mixes/beforeTimer.seconds();
+
+    Timer afterTimer;
+    for (int i=0; i<mixes; ++i) {
+      after.mix(Card(i % m));
+    }
+    double afterRate = mixes/afterTimer.seconds();
+
+    ASSERT_EQ(before,after);
+    std::cout << "n=" << n << " mixes/sec before=" << beforeRate << " after=" << afterRate << " speedup=" << afterRate/beforeRate << std::endl;
+  }
+}
+
+// pad lookups and mixes per second, with and without the inverse index
+double padMixRate(Deck deck, bool indexed, const DeckConfig &cfg) {
+  retain<const DeckConfig> as(&cfg);
+  const int steps = 1000*1000;
+  if (indexed) deck.index();
+  int m = deck.modulus();
+  int sum = 0;
+  Timer timer;
+  for (int i=0; i<steps; ++i) {
+    sum += deck.cipherPad().order;
+    deck.mix(Card(i % m));
+  }
+  double rate = steps/timer.seconds();
+  return (sum >= 0) ? rate : 0;
+}
+
+TEST(Bench,Index) {
+  DeckConfig top40;
+  top40.cipherZth = 5;
+  top40.cipherOffset = 35;
+  top40.cutZth = 1;
+  top40.cutOffset = 38;
+  
+  for (auto cfg : { DeckConfig::DEFAULT, top40 }) {
+    for (auto n : {10, 40, 54}) {
+      Deck deck(n);
+      double scan = padMixRate(deck,false,cfg);
+      double index = padMixRate(deck,true,cfg);
+      std::cout << "cfg=" << cfg.cipherZth << "," << cfg.cipherOffset << "," << cfg.cutZth << "," << cfg.cutOffset << " n=" << n << " steps/sec scan=" << scan << " index=" << index << " speedup=" << index/scan << std::endl;
+    }
+  }
+}
+
+// deck steps (mix and both pads) per second, one indexed deck at a
+// time against all the lanes of a DeckBatch.
+TEST(Bench,Batch) {
+  const int steps = 1000*1000;
+  for (auto n : {10, 40, 54}) {
+    Deck deck(n);
+    deck.index();
+    int m = deck.modulus();
+    int sum = 0;
+    Timer deckTimer;
+    for (int i=0; i<steps; ++i) {
+      deck.mix(Card(i % m));
+      sum += deck.cipherPad().order + deck.cutPad().order;
+    }
+    double deckRate = steps/deckTimer.seconds();
+
+    DeckBatch batch(n);
+    uint8_t plains[DeckBatch::LANES],cipherPads[DeckBatch::LANES],cutPads[DeckBatch::LANES];
+    Timer batchTimer;
+    for (int i=0; i<steps; i += DeckBatch::LANES) {
+      for (int lane=0; lane<DeckBatch::LANES; ++lane) plains[lane]=(i+lane) % m;
+      batch.step(plains,cipherPads,cutPads);
+      sum += cipherPads[0] + cutPads[0];
+    }
+    double batchRate = steps/batchTimer.seconds();
+
+    ASSERT_GE(sum,0);
+    std::cout << "n=" << n << " steps/sec deck=" << deckRate << " batch=" << batchRate << " speedup=" << batchRate/deckRate << std::endl;
+  }
+}
+
+// deck steps (mix and both pads) per second through Deck, which
+// recalls the config every call, and through a compiled DeckKernel.
+TEST(Bench,Kernel) {
+  const int steps = 1000*1000;
+  DeckConfig top40;
+  top40.cipherZth = 5;
+  top40.cipherOffset = 35;
+  top40.cutZth = 1;
+  top40.cutOffset = 38;
+
+  for (auto cfg : { DeckConfig::DEFAULT, top40 }) {
+    retain<const DeckConfig> as(&cfg);
+    for (auto n : {10, 40, 54}) {
+      Deck deck(n), kernelDeck(n);
+      deck.index();
+      kernelDeck.index();
+      int m = deck.modulus();
+      int sum = 0;
+      Timer deckTimer;
+      for (int i=0; i<steps; ++i) {
+	deck.mix(Card(i % m));
+	sum += deck.cipherPad().order + deck.cutPad().order;
+      }
+      double deckRate = steps/deckTimer.seconds();
+
+      DeckKernel kernel(n,kernelDeck.boundConfig());
+      Timer kernelTimer;
+      for (int i=0; i<steps; ++i) {
+	kernel.mix(kernelDeck,Card(i % m));
+	sum -= kernel.cipherPad(kernelDeck).order + kernel.cutPad(kernelDeck).order;
+      }
+      double kernelRate = steps/kernelTimer.seconds();
+
+      ASSERT_EQ(sum,0);
+      ASSERT_EQ(deck,kernelDeck);
+      std::cout << "cfg=" << cfg.cipherZth << "," << cfg.cipherOffset << "," << cfg.cutZth << "," << cfg.cutOffset << " n=" << n << " steps/sec deck=" << deckRate << " kernel=" << kernelRate << " speedup=" << kernelRate/deckRate << std::endl;
+    }
+  }
+}
+
+// keys per second, to and from each format
+TEST(Bench,Codec) {
+  const int decks = 1000, rounds = 1000;
+  XOSHIRO_RNG rng(1);
+  for (auto n : {10, 40, 54}) {
+    std::vector<Deck> shuffled;
+    for (int i=0; i<decks; ++i) {
+      shuffled.push_back(Deck(n));
+      shuffled.back().shuffle(rng);
+    }
+    for (auto format : {DeckCodec::RANK, DeckCodec::PACKED}) {
+      DeckCodec codec(n,format);
+      uint8_t key[DeckCodec::MAX_BYTES];
+      int sum = 0;
+      Timer encodeTimer;
+      for (int r=0; r<rounds; ++r) {
+	for (auto &deck : shuffled) sum += codec.encode(deck,key) + key[0];
+      }
+      double encodeRate = decks*rounds/encodeTimer.seconds();
+
+      Timer decodeTimer;
+      for (int r=0; r<rounds; ++r) {
+	sum += codec.decode(key).cards[0].order;
+      }
+      for (auto &deck : shuffled) {
+	codec.encode(deck,key);
+	for (int r=0; r<rounds; ++r) sum += codec.decode(key).cards[0].order;
+      }
+      double decodeRate = decks*rounds/decodeTimer.seconds();
+
+      std::cout << "n=" << n << (format == DeckCodec::RANK ? " rank" : " packed") << " bytes=" << codec.bytes() << " keys/sec encode=" << encodeRate << " decode=" << decodeRate << " (" << sum % 2 << ")" << std::endl;
+    }
+  }
+}
+
+// 32 bit words per second, one at a time and in bulk
+TEST(Bench,RNG) {
+  const int words = 10*1000*1000;
+  OS_RNG os;
+  SPLITMIX_RNG splitmix(1);
+  XOSHIRO_RNG xoshiro(1);
+  std::vector<uint32_t> buffer(1024);
+  for (RNG *rng : std::vector<RNG*>({&os, &splitmix, &xoshiro})) {
+    uint32_t sum = 0;
+    Timer oneTimer;
+    for (int i=0; i<words; ++i) {
+      sum += rng->next_u32();
+    }
+    double oneRate = words/oneTimer.seconds();
+
+    Timer fillTimer;
+    for (int i=0; i<words; i += buffer.size()) {
+      rng->fill(buffer.data(),buffer.size());
+      sum += buffer[0];
+    }
+    double fillRate = words/fillTimer.seconds();
+
+    std::cout << (rng == &os ? "os" : rng == &splitmix ? "splitmix" : "xoshiro") << " words/sec next_u32=" << oneRate << " fill=" << fillRate << " (" << sum % 2 << ")" << std::endl;
+  }
+}
+
+// shuffles per second, through RNG& and with the generator inlined
+TEST(Bench,Shuffle) {
+  const int shuffles = 1000*1000;
+  for (auto n : {40, 54}) {
+    XOSHIRO_RNG fast(1),slow(1);
+    RNG &virt = slow;
+    Deck a(n),b(n);
+
+    Timer virtTimer;
+    for (int i=0; i<shuffles; ++i) b.shuffle(virt);
+    double virtRate = shuffles/virtTimer.seconds();
+
+    Timer fastTimer;
+    for (int i=0; i<shuffles; ++i) a.shuffle(fast);
+    double fastRate = shuffles/fastTimer.seconds();
+
+    ASSERT_EQ(a,b);
+    std::cout << "n=" << n << " shuffles/sec virtual=" << virtRate << " inline=" << fastRate << " speedup=" << fastRate/virtRate << std::endl;
+  }
+}
+
+// the tables as DeckStats and the Solitaire test used to keep them
+double referenceZLuck(const std::vector<int> &counts) {
+  int n=0;
+  for (size_t i=0; i<counts.size(); ++i) n += counts[i];
+  double mu = n/double(counts.size());
+  double inv_sigma = 1/sqrt(mu);
+  double z=0.0;
+  for (size_t i=0; i<counts.size(); ++i) z += pow(inv_sigma*(counts[i]-mu),2);
+  return sqrt(2.0)*(sqrt(z)-sqrt((counts.size()-1)-0.5));
+}
+
+// z-trials per second: allocate, count pairs, z; against reset, push, z
+TEST(Bench,Histogram) {
+  const int counts = 100*1000;
+  for (auto dims : {2, 4}) {
+    const int bins = (dims == 2) ? 40 : 52;
+    const int zTrials = (dims == 2) ? 200 : 10;
+    size_t cells = 1;
+    for (int d=0; d<dims; ++d) cells *= bins;
+
+    XOSHIRO_RNG rng(1);
+    double sum = 0;
+    Timer beforeTimer;
+    for (int z=0; z<zTrials; ++z) {
+      std::vector<int> table(cells,0);
+      size_t cell = 0;
+      for (int t=0; t<counts; ++t) {
+	cell = (cell*bins + rng.next(0,bins-1)) % cells;
+	++table[cell];
+      }
+      sum += referenceZLuck(table);
+    }
+    double beforeRate = zTrials/beforeTimer.seconds();
+
+    Histogram table(bins,dims);
+    Timer afterTimer;
+    for (int z=0; z<zTrials; ++z) {
+      table.reset();
+      for (int t=0; t<counts; ++t) {
+	table.push(rng.next(0,bins-1));
+      }
+      sum += table.z();
+    }
+    double afterRate = zTrials/afterTimer.seconds();
+
+    std::cout << "cells=" << cells << " z-trials/sec before=" << beforeRate << " after=" << afterRate << " speedup=" << afterRate/beforeRate << " (" << (sum != 0) << ")" << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
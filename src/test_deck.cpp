@@ -1,7 +1,9 @@
 #include <iostream>
+#include <thread>
 #include "gtest/gtest.h"
 #include "retain.hpp"
 #include "deck.h"
+#include "test_configs.h"
 
 using namespace std;
 using namespace spider;
@@ -86,23 +88,59 @@ TEST(Deck,RetainConfig) {
   test_recall();
 }
 
-std::vector<DeckConfig> configs() {
-  std::vector<DeckConfig> cfgs;
-  DeckConfig cfg;  
-  for (auto cipherZth : {0,1,2,3,4,5}) {
-    cfg.cipherZth = cipherZth;
-    for (auto cipherOffset : {-1,0,1,2,3,4,5,35,36,37,38,39}) {
-      cfg.cipherOffset=cipherOffset;
-      for (auto cutZth : {0,1,2,3,4,5}) {
-	cfg.cutZth = cutZth;
-	for (auto cutOffset : {-1,0,1,2,3,4,5,35,36,37,38,39}) {
-	  cfg.cutOffset=cutOffset;
-	  cfgs.push_back(cfg);
-	}
-      }
+// each thread recalls its own retained config
+TEST(Deck,RetainThreads) {
+  DeckConfig cfg;
+  cfg.cipherZth = -1;
+  cfg.cipherOffset = -2;
+  cfg.cutZth = -3;
+  cfg.cutOffset = -4;
+  retain<const DeckConfig> as(&cfg);
+  bool fresh = false;
+  std::thread other([&]() { fresh = !retained<const DeckConfig>(); });
+  other.join();
+  ASSERT_TRUE(fresh);
+  ASSERT_EQ(recall<const DeckConfig>(),&cfg);
+  test_recall();
+}
+
+// bound decks ignore the recalled config and keep their own
+TEST(Deck,Bind) {
+  DeckConfig top40;
+  top40.cipherZth = 5;
+  top40.cipherOffset = 35;
+  top40.cutZth = 1;
+  top40.cutOffset = 38;
+
+  TEST_RNG rng(1);
+  Deck plain(40);
+  plain.shuffle(rng);
+  Deck defaults(plain), bound(plain), retained(plain);
+  bound.bind(&top40);
+  defaults.bind(&DeckConfig::DEFAULT);
+  for (int i=0; i<100; ++i) {
+    Card card(i % 40);
+    {
+      retain<const DeckConfig> as(&top40);
+      ASSERT_EQ(bound.cipherPad(),retained.cipherPad());
+      ASSERT_EQ(bound.cutPad(),retained.cutPad());
+      retained.mix(card);
+    }
+    ASSERT_EQ(defaults.cipherPad(),plain.cipherPad());
+    ASSERT_EQ(defaults.cutPad(),plain.cutPad());
+    plain.mix(card);
+    {
+      retain<const DeckConfig> as(&top40);
+      defaults.mix(card);
     }
+    bound.mix(card);
+    ASSERT_EQ(bound,retained);
+    ASSERT_EQ(defaults,plain);
   }
-  return cfgs;
+  Deck copy(bound);
+  ASSERT_EQ(&copy.boundConfig(),&top40);
+  copy.bind(0);
+  ASSERT_EQ(&copy.boundConfig(),&DeckConfig::DEFAULT);
 }
 
 TEST(Deck,Equivalent) {
@@ -122,7 +160,7 @@ TEST(Deck,Equivalent) {
     ASSERT_EQ(equivalent(c,b),0);
     ASSERT_EQ(c.cipherPad(),b.cipherPad());
     ASSERT_EQ(c.cutPad(),b.cutPad());
-    for (auto cfg : configs()) {
+    for (auto cfg : testConfigs()) {
       retain<const DeckConfig> as(&cfg);
       for (int i=0; i<a.modulus(); ++i) {
 	Deck bmix(b);
@@ -177,6 +215,57 @@ TEST(Deck,BackFrontUnshuffle) {
   }
 }
 
+TEST(Deck,CutBackFrontShuffle) {
+  for (auto n : {10, 40, 41, 52, 54}) {
+    Deck a(n);
+    shuffle(a);
+    for (int cutLoc=0; cutLoc<n; ++cutLoc) {
+      std::vector<Card> tmp,expect;
+      Deck::cut(a.cards,cutLoc,tmp);
+      Deck::backFrontShuffle(tmp,expect);
+      Deck b(a);
+      Deck::cutBackFrontShuffle(&b.cards[0],n,cutLoc);
+      ASSERT_EQ(b.cards,expect) << " n=" << n << " cutLoc=" << cutLoc;
+    }
+  }
+}
+
+// the static helpers on inline cards agree with pseudoShuffle
+TEST(Deck,InlineCards) {
+  for (unsigned n : {10u, 40u}) {
+    Deck a(n);
+    shuffle(a);
+    CardArray cards(a.cards);
+    ASSERT_EQ(cards,a.cards);
+    for (unsigned cutLoc=0; cutLoc<n; ++cutLoc) {
+      CardArray tmp(n),out(n);
+      Deck::cut(cards,cutLoc,tmp);
+      Deck::backFrontShuffle(tmp,out);
+      Deck b(a);
+      b.pseudoShuffle(a.cards[cutLoc]);
+      ASSERT_EQ(out,b.cards) << " n=" << n << " cutLoc=" << cutLoc;
+      ASSERT_EQ(Deck::padLoc(out,2,39,b.modulus()),Deck::padLoc(b.cards,2,39,b.modulus()));
+    }
+  }
+  // new cards are blank
+  CardArray cards(3);
+  cards.resize(5);
+  for (auto card : cards) ASSERT_EQ(card,Card(0));
+}
+
+TEST(Deck,ShuffleGenerator) {
+  for (auto n : {10, 40, 54}) {
+    XOSHIRO_RNG fast(n),slow(n);
+    RNG &virt = slow;
+    for (int i=0; i<100; ++i) {
+      Deck a(n),b(n);
+      a.shuffle(fast);
+      b.shuffle(virt);
+      ASSERT_EQ(a,b);
+    }
+  }
+}
+
 TEST(Deck,Forward) {
   for (auto n : {10, 40, 41, 52, 54}) {
     Deck a(n);
@@ -285,7 +374,7 @@ TEST(Deck,Before) {
 }
 
 TEST(Deck,Mix) {
-  for (auto cfg : configs()) {
+  for (auto cfg : testConfigs()) {
     retain<const DeckConfig> as(&cfg);
     for (auto n : {10, 40, 41, 52, 54}) {
       for (int len=1; len<10; ++len) {
@@ -323,6 +412,34 @@ TEST(Deck,Mix) {
   }
 }
 
+TEST(Deck,Index) {
+  for (auto cfg : testConfigs()) {
+    retain<const DeckConfig> as(&cfg);
+    for (auto n : {10, 40, 41, 52, 54}) {
+      Deck plain(n);
+      shuffle(plain);
+      Deck indexed(plain);
+      indexed.index();
+      for (int i=0; i<20; ++i) {
+	for (int card=0; card<n; ++card) {
+	  ASSERT_EQ(indexed.find(Card(card)),plain.find(Card(card)));
+	}
+	ASSERT_EQ(indexed.cipherPad(),plain.cipherPad());
+	ASSERT_EQ(indexed.cutPad(),plain.cutPad());
+	Card card((i*31+17)%plain.modulus());
+	if (i % 5 == 4) {
+	  indexed.unmix(card);
+	  plain.unmix(card);
+	} else {
+	  indexed.mix(card);
+	  plain.mix(card);
+	}
+	ASSERT_EQ(indexed,plain);
+      }
+    }
+  }
+}
+
 TEST(Deck,Unmix) {
   for (auto n : {10, 40, 41, 52, 54}) {
     Deck a(n);
@@ -348,7 +465,7 @@ TEST(Deck,Unmix) {
 
 
 TEST(Deck,CipherPad) {
-  for (auto cfg : configs()) {
+  for (auto cfg : testConfigs()) {
     retain<const DeckConfig> as(&cfg);
     for (auto n : {10, 40, 41, 52, 54}) {
       Deck a(n);
@@ -396,7 +513,7 @@ TEST(Deck,CipherPad) {
 
 
 TEST(Deck,CutPad) {
-  for (auto cfg : configs()) {
+  for (auto cfg : testConfigs()) {
     retain<const DeckConfig> as(&cfg);
     for (auto n : {10, 40, 41, 52, 54}) {
     Deck a(n);
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "retain.hpp"
+#include "rng.h"
+#include "deck.h"
+#include "deck_batch.h"
+#include "test_configs.h"
+
+using namespace std;
+using namespace spider;
+
+TEST(DeckBatch,SetGet) {
+  for (auto n : {10, 40, 41, 52, 54}) {
+    DeckBatch batch(n);
+    Deck ordered(n);
+    for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+      ASSERT_EQ(batch.get(lane),ordered);
+    }
+    ASSERT_EQ(batch.modulus(),ordered.modulus());
+
+    std::vector<Deck> decks;
+    for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+      TEST_RNG rng(lane);
+      Deck deck(n);
+      deck.shuffle(rng);
+      batch.set(lane,deck);
+      decks.push_back(deck);
+    }
+    for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+      ASSERT_EQ(batch.get(lane),decks[lane]);
+    }
+  }
+}
+
+// every lane tracks its own Deck through mixes with per lane plain cards
+TEST(DeckBatch,Step) {
+  OS_RNG rng;
+  for (auto cfg : testConfigs(23)) {
+    retain<const DeckConfig> as(&cfg);
+    for (auto n : {10, 40, 41, 52, 54}) {
+      DeckBatch batch(n);
+      std::vector<Deck> decks;
+      for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+	Deck deck(n);
+	deck.shuffle(rng);
+	batch.set(lane,deck);
+	decks.push_back(deck);
+      }
+
+      int m = batch.modulus();
+      uint8_t plains[DeckBatch::LANES],cipherPads[DeckBatch::LANES],cutPads[DeckBatch::LANES];
+      for (int i=0; i<8; ++i) {
+	batch.cipherPads(cipherPads);
+	batch.cutPads(cutPads);
+	for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+	  ASSERT_EQ(Card(cipherPads[lane]),decks[lane].cipherPad());
+	  ASSERT_EQ(Card(cutPads[lane]),decks[lane].cutPad());
+	  plains[lane]=rng.next(0,m-1);
+	}
+	if (i % 2 == 0) {
+	  batch.mix(plains);
+	} else {
+	  batch.step(plains,cipherPads,cutPads);
+	}
+	for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+	  decks[lane].mix(Card(plains[lane]));
+	  ASSERT_EQ(batch.get(lane),decks[lane]);
+	  if (i % 2 == 1) {
+	    ASSERT_EQ(Card(cipherPads[lane]),decks[lane].cipherPad());
+	    ASSERT_EQ(Card(cutPads[lane]),decks[lane].cutPad());
+	  }
+	}
+      }
+    }
+  }
+}
+
+// a bound batch keeps its config whatever is retained
+TEST(DeckBatch,Bind) {
+  DeckConfig top40;
+  top40.cipherZth = 5;
+  top40.cipherOffset = 35;
+  top40.cutZth = 1;
+  top40.cutOffset = 38;
+  DeckBatch batch(40);
+  {
+    // the batch keeps a copy of the config it was bound to
+    DeckConfig scoped = top40;
+    batch.bind(&scoped);
+    scoped = DeckConfig::DEFAULT;
+  }
+  std::vector<Deck> decks;
+  for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+    TEST_RNG rng(lane+1);
+    Deck deck(40);
+    deck.shuffle(rng);
+    deck.bind(&top40);
+    batch.set(lane,deck);
+    decks.push_back(deck);
+  }
+  uint8_t plains[DeckBatch::LANES],cipherPads[DeckBatch::LANES],cutPads[DeckBatch::LANES];
+  for (int i=0; i<40; ++i) {
+    for (int lane=0; lane<DeckBatch::LANES; ++lane) plains[lane]=(i+lane) % 40;
+    batch.step(plains,cipherPads,cutPads);
+    for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+      decks[lane].mix(Card(plains[lane]));
+      ASSERT_EQ(batch.get(lane),decks[lane]);
+      ASSERT_EQ(Card(cipherPads[lane]),decks[lane].cipherPad());
+      ASSERT_EQ(Card(cutPads[lane]),decks[lane].cutPad());
+    }
+  }
+}
+
+// the lanes only share the deck size, every cut location is exercised
+TEST(DeckBatch,AllCuts) {
+  for (auto n : {10, 40, 41, 52, 54}) {
+    DeckBatch batch(n);
+    std::vector<Deck> decks;
+    for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+      TEST_RNG rng(lane*7+1);
+      Deck deck(n);
+      deck.shuffle(rng);
+      batch.set(lane,deck);
+      decks.push_back(deck);
+    }
+    int m = batch.modulus();
+    uint8_t plains[DeckBatch::LANES];
+    for (int plain=0; plain<m; ++plain) {
+      for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+	plains[lane]=(plain+lane) % m;
+	decks[lane].mix(Card(plains[lane]));
+      }
+      batch.mix(plains);
+      for (int lane=0; lane<DeckBatch::LANES; ++lane) {
+	ASSERT_EQ(batch.get(lane),decks[lane]);
+      }
+    }
+  }
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <vector>
+#include <string.h>
+#include <algorithm>
+#include "gtest/gtest.h"
+#include "rng.h"
+#include "deck.h"
+#include "deck_codec.h"
+
+using namespace std;
+using namespace spider;
+
+TEST(DeckCodec,Bytes) {
+  ASSERT_EQ(DeckCodec(10).bytes(),3u);
+  ASSERT_EQ(DeckCodec(40).bytes(),20u);
+  ASSERT_EQ(DeckCodec(54).bytes(),30u);
+  ASSERT_EQ(DeckCodec(10,DeckCodec::PACKED).bytes(),8u);
+  ASSERT_EQ(DeckCodec(40,DeckCodec::PACKED).bytes(),30u);
+  ASSERT_EQ(DeckCodec(54,DeckCodec::PACKED).bytes(),41u);
+}
+
+// ranks count permutations in lexicographic order
+TEST(DeckCodec,Rank) {
+  for (auto n : {5, 10}) {
+    DeckCodec codec(n);
+    Deck deck(n);
+    std::vector<uint8_t> cards(n);
+    for (int i=0; i<n; ++i) cards[i]=i;
+    uint64_t expect = 0;
+    do {
+      for (int i=0; i<n; ++i) deck.cards[i]=Card(cards[i]);
+      uint8_t key[DeckCodec::MAX_BYTES];
+      ASSERT_EQ(codec.encode(deck,key),0);
+      uint64_t rank = 0;
+      memcpy(&rank,key,codec.bytes());
+      ASSERT_EQ(rank,expect);
+      if (expect % 997 == 0) {
+	ASSERT_EQ(codec.decode(key),deck);
+      }
+      ++expect;
+    } while (std::next_permutation(cards.begin(),cards.end()));
+    ASSERT_EQ(expect,n == 5 ? 120u : 3628800u);
+  }
+}
+
+TEST(DeckCodec,RoundTrip) {
+  XOSHIRO_RNG rng(16);
+  for (auto format : {DeckCodec::RANK, DeckCodec::PACKED}) {
+    for (auto n : {1, 2, 10, 11, 40, 41, 52, 54}) {
+      DeckCodec codec(n,format);
+      for (int i=0; i<200; ++i) {
+	Deck deck(n);
+	deck.shuffle(rng);
+	uint8_t key[DeckCodec::MAX_BYTES];
+	int rotation = codec.encode(deck,key);
+	ASSERT_EQ(rotation,DeckCodec::rotation(deck));
+	ASSERT_EQ(codec.decode(key,rotation),deck);
+	Deck canonical = codec.decode(key);
+	ASSERT_EQ(equivalent(canonical,deck),0);
+      }
+    }
+  }
+}
+
+// equivalent decks share a key, others do not
+TEST(DeckCodec,Equivalent) {
+  XOSHIRO_RNG rng(17);
+  for (auto format : {DeckCodec::RANK, DeckCodec::PACKED}) {
+    for (auto n : {10, 40, 52, 54}) {
+      DeckCodec codec(n,format);
+      for (int i=0; i<200; ++i) {
+	Deck a(n), b(n);
+	a.shuffle(rng);
+	int shift = rng.next(0,n-1);
+	for (int j=0; j<n; ++j) b.cards[j]=a.cards[(j+shift) % n];
+	uint8_t ka[DeckCodec::MAX_BYTES], kb[DeckCodec::MAX_BYTES];
+	codec.encode(a,ka);
+	codec.encode(b,kb);
+	ASSERT_EQ(memcmp(ka,kb,codec.bytes()) == 0,equivalent(a,b) == 0) << a << " " << b;
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "retain.hpp"
+#include "rng.h"
+#include "deck.h"
+#include "deck_kernel.h"
+#include "messenger.h"
+
+using namespace std;
+using namespace spider;
+
+std::vector<DeckConfig> configs() {
+  std::vector<DeckConfig> cfgs;
+  DeckConfig cfg;
+  // 7 and 20 are not compiled
+  for (auto cipherZth : {0,1,2,5,7}) {
+    cfg.cipherZth = cipherZth;
+    for (auto cipherOffset : {-1,0,1,20,35,39}) {
+      cfg.cipherOffset=cipherOffset;
+      for (auto cutZth : {0,1,3}) {
+	cfg.cutZth = cutZth;
+	for (auto cutOffset : {-1,0,2,38}) {
+	  cfg.cutOffset=cutOffset;
+	  cfgs.push_back(cfg);
+	}
+      }
+    }
+  }
+  return cfgs;
+}
+
+TEST(DeckKernel,Dispatch) {
+  for (auto n : {10u, 40u, 52u, 54u}) {
+    ASSERT_TRUE(DeckKernel(n,DeckConfig::DEFAULT).specialized());
+  }
+  DeckConfig odd = DeckConfig::DEFAULT;
+  odd.cipherOffset = 20;
+  ASSERT_FALSE(DeckKernel(40,odd).specialized());
+  ASSERT_FALSE(DeckKernel(41,DeckConfig::DEFAULT).specialized());
+  ASSERT_EQ(DeckKernel(41,DeckConfig::DEFAULT).cipher,&DeckKernel::generic);
+
+  // the kernel keeps the config it is given
+  ASSERT_EQ(DeckKernel(40,odd).cfg.cipherOffset,20);
+}
+
+// the kernel pads and mixes track Deck, compiled or not, indexed or not
+TEST(DeckKernel,Pads) {
+  OS_RNG rng;
+  for (auto cfg : configs()) {
+    retain<const DeckConfig> as(&cfg);
+    for (auto n : {10, 40, 41, 52, 54}) {
+      DeckKernel kernel(n,Deck::config());
+      for (auto indexed : {false, true}) {
+	Deck deck(n), expect(n);
+	deck.shuffle(rng);
+	if (indexed) deck.index();
+	expect = deck;
+	for (int i=0; i<20; ++i) {
+	  ASSERT_EQ(kernel.cipherPad(deck),expect.cipherPad());
+	  ASSERT_EQ(kernel.cutPad(deck),expect.cutPad());
+	  Card plain(rng.next(0,deck.modulus()-1));
+	  kernel.mix(deck,plain);
+	  expect.mix(plain);
+	  ASSERT_EQ(deck,expect);
+	}
+      }
+    }
+  }
+}
+
+// Messenger runs its kernel under the config its key is bound to
+TEST(DeckKernel,BoundKey) {
+  DeckConfig odd = DeckConfig::DEFAULT;
+  odd.cipherOffset = 20;
+  odd.cutOffset = 3;
+  TEST_RNG rng(7);
+  for (auto n : {10, 40}) {
+    Deck key(n);
+    key.shuffle(rng);
+    key.bind(&odd);
+    Messenger messenger(rng,n,0,0,0);
+    messenger.key(key);
+    std::vector<Card> plains;
+    for (int i=0; i<30; ++i) plains.push_back(Card(rng.next(0,key.modulus()-1)));
+    messenger.plaincards(plains);
+    messenger.encrypt();
+
+    Deck expect(key);
+    std::vector<Card> ciphers;
+    for (auto plain : plains) {
+      ciphers.push_back(expect.addMod(plain,expect.cipherPad()));
+      expect.mix(plain);
+    }
+    ASSERT_EQ(messenger.ciphercards(),ciphers) << "n=" << n;
+
+    messenger.plaincards(std::vector<Card>());
+    messenger.decrypt();
+    ASSERT_EQ(messenger.plaincards(),plains) << "n=" << n;
+  }
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
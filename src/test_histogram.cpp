@@ -0,0 +1,111 @@
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include "gtest/gtest.h"
+#include "rng.h"
+#include "histogram.h"
+
+using namespace std;
+using namespace spider;
+
+// the z of a flat table, as test_stats and test_solitare computed it
+double referenceZ(const std::vector<int> &counts) {
+  double n=0;
+  for (auto count : counts) n += count;
+  double mu = n/counts.size();
+  double chi2 = 0;
+  for (auto count : counts) chi2 += pow(count-mu,2)/mu;
+  return sqrt(2.0)*(sqrt(chi2)-sqrt(counts.size()-1.5));
+}
+
+TEST(Histogram,Add) {
+  XOSHIRO_RNG rng(1);
+  for (int bins : {10, 40, 52}) {
+    Histogram h1(bins), h2(bins,2);
+    std::vector<int> c1(bins,0), c2(bins*bins,0);
+    for (int i=0; i<100000; ++i) {
+      int a = rng.next(0,bins-1), b = rng.next(0,bins-1);
+      h1.add(h1.cell(a));
+      h2.add(h2.cell(a,b));
+      ++c1[a];
+      ++c2[a*bins+b];
+    }
+    ASSERT_EQ(h1.total(),100000u);
+    ASSERT_EQ(h1.cells(),size_t(bins));
+    ASSERT_EQ(h2.cells(),size_t(bins*bins));
+    for (int i=0; i<bins*bins; ++i) {
+      if (i < bins) {
+	ASSERT_EQ(h1[i],uint32_t(c1[i]));
+      }
+      ASSERT_EQ(h2[i],uint32_t(c2[i]));
+    }
+    ASSERT_EQ(h1.squares(),h1.m_squares);
+    ASSERT_EQ(h2.squares(),h2.m_squares);
+    ASSERT_NEAR(h1.z(),referenceZ(c1),1e-9);
+    ASSERT_NEAR(h2.z(),referenceZ(c2),1e-9);
+  }
+}
+
+TEST(Histogram,Push) {
+  // lag 1 pairs, lag 3 pairs, non-overlapping triples
+  Histogram pairs(10,2), lagged(10,2,3), triples(10,3,1,3);
+  std::vector<int> xs;
+  XOSHIRO_RNG rng(2);
+  std::vector<int> c2(100,0), c2lag(100,0), c3(1000,0);
+  for (int t=0; t<5000; ++t) {
+    int x = rng.next(0,9);
+    xs.push_back(x);
+    pairs.push(x);
+    lagged.push(x);
+    triples.push(x);
+    if (t >= 1) ++c2[xs[t-1]*10+x];
+    if (t >= 3) ++c2lag[xs[t-3]*10+x];
+    if (t % 3 == 2) ++c3[xs[t-2]*100+xs[t-1]*10+x];
+  }
+  for (int i=0; i<1000; ++i) {
+    if (i < 100) {
+      ASSERT_EQ(pairs[i],uint32_t(c2[i]));
+      ASSERT_EQ(lagged[i],uint32_t(c2lag[i]));
+    }
+    ASSERT_EQ(triples[i],uint32_t(c3[i]));
+  }
+  ASSERT_EQ(pairs.total(),4999u);
+  ASSERT_EQ(lagged.total(),4997u);
+  ASSERT_EQ(triples.total(),5000u/3);
+}
+
+TEST(Histogram,Reset) {
+  Histogram h(40,2);
+  for (int i=0; i<1000; ++i) h.push(i % 40);
+  Histogram copy(h);
+  h.reset();
+  ASSERT_EQ(h.total(),0u);
+  ASSERT_EQ(h.squares(),0u);
+  ASSERT_EQ(h.chi2(),0.0);
+  h.push(3);
+  ASSERT_EQ(h.total(),0u);
+  h.push(4);
+  ASSERT_EQ(h[h.cell(3,4)],1u);
+
+  ASSERT_EQ(copy.total(),999u);
+  ASSERT_EQ(copy.squares(),copy.m_squares);
+  Histogram moved(std::move(copy));
+  ASSERT_EQ(moved.total(),999u);
+  ASSERT_EQ(moved[moved.cell(0,1)],25u);
+  ASSERT_EQ(uintptr_t(moved.m_counts) % 64,0u);
+}
+
+// a good generator looks uniform: z is about N(0,1)
+TEST(Histogram,Uniform) {
+  XOSHIRO_RNG rng(3);
+  Histogram h1(40), h2(40,2), h4(10,4,1,4);
+  for (int i=0; i<400000; ++i) {
+    int x = rng.next(0,39);
+    h1.push(x);
+    h2.push(x);
+    h4.push(x % 10);
+  }
+  ASSERT_LT(fabs(h1.z()),5.0);
+  ASSERT_LT(fabs(h2.z()),5.0);
+  ASSERT_LT(fabs(h4.z()),5.0);
+}
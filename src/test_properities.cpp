@@ -1,6 +1,7 @@
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include "gtest/gtest.h"
 #include "deck.h"
 #include "search.h"
@@ -290,8 +291,10 @@ TEST(Properties,ReverseBackFrontShuffleIsFrontBackShuffle) {
   Deck rbfShuffle(n);
   Deck::backFrontShuffle(deck1.cards,rbfShuffle.cards);
   R(rbfShuffle);
+  std::vector<Card> fbCards;
+  frontBackShuffle(deck2.cards,fbCards);
   Deck fbShuffle(n);
-  frontBackShuffle(deck2.cards,fbShuffle.cards);
+  fbShuffle.cards = fbCards;
   ASSERT_EQ(fbShuffle,rbfShuffle);
 }
 
@@ -487,6 +490,69 @@ TEST(Properties,ExchangeDiamondsSpades) {
   ASSERT_EQ(xform("Z"),exchanged);  
 }
 
+// the decks one mix away from deck, for every plain card
+std::vector<Deck> mixes(const Deck &deck) {
+  std::vector<Deck> ans;
+  for (int plain=0; plain<int(deck.cards.size()); ++plain) {
+    Deck next(deck);
+    next.mix(Card(plain));
+    ans.push_back(next);
+  }
+  return ans;
+}
+
+bool contains(const std::vector<Deck> &decks, const Deck &deck) {
+  return std::find(decks.begin(),decks.end(),deck) != decks.end();
+}
+
+//
+// Relabeling the cards (here CDHS -> DCSH) maps the decks one mix away
+// onto the relabeled decks one mix away, with other plain cards: every
+// plain card reaches every cut location.  But no relabeling fixes a
+// deck, so a search from one deck to another cannot identify states by
+// relabeling without losing its endpoints.
+//
+TEST(Properties,RelabelMixes) {
+  auto relabel = [](const Deck &deck) {
+    Deck ans(deck);
+    for (auto &card : ans.cards) {
+      int suite = card.order/10;
+      int newSuite = (suite % 2 == 0) ? suite+1 : suite-1;
+      card = Card(newSuite*10+card.order%10);
+    }
+    return ans;
+  };
+  Deck deck(xform("P^3 T^7 Q P^5"));
+  std::vector<Deck> after = mixes(deck);
+  std::vector<Deck> relabeled = mixes(relabel(deck));
+  for (auto &next : after) {
+    ASSERT_TRUE(contains(relabeled,relabel(next)));
+  }
+  ASSERT_NE(relabel(deck),deck);
+}
+
+//
+// Nor do the position symmetries: conjugating the cut and back-front
+// shuffle steps by a rotation, R, X, Y or Z never maps all of them
+// back onto steps, so none is a symmetry of the search graph.
+//
+TEST(Properties,NoStepSymmetry) {
+  int n = 40;
+  std::vector<Deck> steps = mixes(Deck(n));
+  std::vector<std::string> xs = { "R", "X", "Y", "Z" };
+  for (int t=1; t<n; ++t) xs.push_back("T^" + std::to_string(t));
+  for (auto &x : xs) {
+    std::string inverse = (x[0] == 'T') ? "T^" + std::to_string(n-std::stoi(x.substr(2))) : x;
+    bool all = true;
+    for (int i=0; i<n && all; ++i) {
+      Deck conjugate(xform(inverse));
+      conjugate.pseudoShuffle(conjugate.cards[i]);
+      all = contains(steps,xform(x,conjugate));
+    }
+    ASSERT_FALSE(all) << x;
+  }
+}
+
 int main(int argc, char** argv) {
   if (argc > 1 && argv[1][0] != '-') {
     for (int i=1; i<argc; ++i) {
@@ -1,5 +1,9 @@
 #include <iostream>
 #include <math.h>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "gtest/gtest.h"
 #include "rng.h"
 
@@ -61,6 +65,180 @@ TEST(OS_RNG,Stats) {
   }
 }
 
+// after a fork, parent and child must not share the buffered words
+TEST(OS_RNG,Fork) {
+  OS_RNG rng;
+  rng.next_u32();
+  int fds[2];
+  ASSERT_EQ(pipe(fds),0);
+  pid_t pid = fork();
+  ASSERT_GE(pid,0);
+  if (pid == 0) {
+    uint32_t words[4];
+    rng.fill(words,4);
+    ssize_t status = write(fds[1],words,sizeof(words));
+    _exit(status == sizeof(words) ? 0 : 1);
+  }
+  uint32_t mine[4],theirs[4];
+  rng.fill(mine,4);
+  ASSERT_EQ(read(fds[0],theirs,sizeof(theirs)),(ssize_t) sizeof(theirs));
+  int status;
+  waitpid(pid,&status,0);
+  close(fds[0]);
+  close(fds[1]);
+  ASSERT_NE(memcmp(mine,theirs,sizeof(mine)),0);
+}
+
+TEST(OS_RNG,Fill) {
+  OS_RNG rng;
+  for (size_t n : {1, 3, 255, 256, 257, 5000}) {
+    std::vector<uint32_t> words(n,0);
+    rng.next_u32();
+    rng.fill(words.data(),n);
+    int bits = 0;
+    for (auto word : words) bits += __builtin_popcount(word);
+    double mu = 16.0*n, sigma = sqrt(8.0*n);
+    ASSERT_LT(fabs(bits-mu)/sigma,5.0);
+  }
+}
+
+TEST(SPLITMIX_RNG,Reference) {
+  SPLITMIX_RNG rng(1234567);
+  ASSERT_EQ(rng.next_u64(),6457827717110365317ULL);
+  ASSERT_EQ(rng.next_u64(),3203168211198807973ULL);
+  ASSERT_EQ(rng.next_u64(),9817491932198370423ULL);
+
+  SPLITMIX_RNG a(42),b(42);
+  for (int i=0; i<100; ++i) {
+    ASSERT_EQ(a.next_u32(),b.next_u32());
+  }
+}
+
+TEST(SPLITMIX_RNG,Stats) {
+  int n = 1000000;
+  int counts[10];
+  SPLITMIX_RNG rng(1);
+  for (int k=0; k<10; ++k) counts[k]=0;
+  for (int i=0; i<n; ++i) {
+    ++counts[rng.next(0,9)];
+  }
+  double p = 0.1, q = 0.9;
+  for (int k=0; k<10; ++k) {
+    ASSERT_LT(fabs((counts[k]-n*p)/sqrt(n*p*q)),4.0);
+  }
+}
+
+TEST(XOSHIRO_RNG,Reference) {
+  XOSHIRO_RNG rng(1,2,3,4);
+  ASSERT_EQ(rng.next_u64(),11520ULL);
+  ASSERT_EQ(rng.next_u64(),0ULL);
+  ASSERT_EQ(rng.next_u64(),1509978240ULL);
+  ASSERT_EQ(rng.next_u64(),1215971899390074240ULL);
+}
+
+TEST(XOSHIRO_RNG,Fill) {
+  for (size_t n : {0, 1, 2, 7, 64, 1001}) {
+    XOSHIRO_RNG a(n),b(n);
+    a.next_u32();
+    b.next_u32();
+    std::vector<uint32_t> words(n);
+    a.fill(words.data(),n);
+    for (size_t i=0; i<n; ++i) {
+      ASSERT_EQ(words[i],b.next_u32());
+    }
+    ASSERT_EQ(a.next_u32(),b.next_u32());
+  }
+}
+
+TEST(XOSHIRO_RNG,Jump) {
+  XOSHIRO_RNG a(7),b(7);
+  a.jump();
+  b.jump();
+  for (int i=0; i<100; ++i) {
+    ASSERT_EQ(a.next_u64(),b.next_u64());
+  }
+  XOSHIRO_RNG c(7),d(7);
+  c.jump();
+  d.long_jump();
+  XOSHIRO_RNG e(7);
+  int same = 0;
+  for (int i=0; i<1000; ++i) {
+    uint64_t x = c.next_u64(), y = d.next_u64(), z = e.next_u64();
+    same += (x == y) + (y == z) + (x == z);
+  }
+  ASSERT_EQ(same,0);
+}
+
+// chi-square of 32 bucket counts, and of 16x16 pairs of consecutive
+// values, within each stream and across jumped streams.
+TEST(XOSHIRO_RNG,Stats) {
+  const int n = 1000000;
+  XOSHIRO_RNG rng(2024);
+  XOSHIRO_RNG streams[2] = { rng, rng };
+  streams[1].jump();
+
+  std::vector<uint32_t> words(n);
+  rng.fill(words.data(),n);
+  std::vector<int> counts(32,0), pairs(256,0), across(256,0);
+  for (int i=0; i<n; ++i) {
+    ++counts[words[i] >> 27];
+    if (i > 0) ++pairs[(words[i-1] >> 28)*16 + (words[i] >> 28)];
+    ++across[(streams[0].next_u32() >> 28)*16 + (streams[1].next_u32() >> 28)];
+  }
+
+  for (auto bins : { &counts, &pairs, &across }) {
+    double total = 0;
+    for (auto count : *bins) total += count;
+    double mu = total/bins->size();
+    double chi2 = 0;
+    for (auto count : *bins) chi2 += pow(count-mu,2)/mu;
+    // chi-square with k-1 degrees of freedom is about normal for large k
+    double k = bins->size()-1;
+    double z = (chi2-k)/sqrt(2*k);
+    ASSERT_LT(fabs(z),5.0);
+  }
+
+  int draws[10] = {0};
+  for (int i=0; i<n; ++i) {
+    ++draws[rng.next(0,9)];
+  }
+  for (int k=0; k<10; ++k) {
+    ASSERT_LT(fabs((draws[k]-n*0.1)/sqrt(n*0.1*0.9)),4.0);
+  }
+}
+
+TEST(RNG,Lemire) {
+  // every n, a near power of two and a bound close to 2^32
+  for (uint32_t n : {1u, 2u, 3u, 10u, 40u, 52u, 65u, 3000000000u}) {
+    XOSHIRO_RNG rng(n);
+    const int draws = 200000;
+    const int bins = 10;
+    std::vector<int> counts(bins,0);
+    for (int i=0; i<draws; ++i) {
+      uint32_t x = lemire(rng,n);
+      ASSERT_LT(x,n);
+      ++counts[uint64_t(x)*bins/n];
+    }
+    if (n >= 10 && n % 10 == 0) {
+      for (auto count : counts) {
+	ASSERT_LT(fabs((count-draws*0.1)/sqrt(draws*0.1*0.9)),5.0);
+      }
+    }
+  }
+}
+
+// the inlined and the virtual draws of a generator are the same draws
+TEST(RNG,Inline) {
+  XOSHIRO_RNG fast(99),slow(99);
+  RNG &virt = slow;
+  for (int i=0; i<10000; ++i) {
+    int b = i % 60;
+    ASSERT_EQ(fast.next(0,b),virt.next(0,b));
+    ASSERT_EQ(fast.next_u32(b+1),virt.next_u32(b+1));
+    ASSERT_EQ(fast.next_u32(),virt.next_u32());
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -1,7 +1,15 @@
 #include <iostream>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <math.h>
+#include <memory>
 #include "gtest/gtest.h"
+#include "rng.h"
+#include "retain.hpp"
 #include "deck.h"
 #include "search.h"
+#include "search_disk.h"
 
 using namespace std;
 using namespace spider;
@@ -45,6 +53,52 @@ TEST(Search,SearchSet) {
   }
 }
 
+// the hash set agrees with a std::set ordered by equivalent()
+TEST(Search,SearchSetHash) {
+  for (auto format : {DeckCodec::PACKED, DeckCodec::RANK}) {
+    for (auto n : {10, 40, 41, 52, 54}) {
+      SearchSet s(format);
+      std::set<Deck,SearchSetCmp> expect;
+      std::vector<Deck> firsts;
+      TEST_RNG rng(n);
+      for (int i=0; i<5000; ++i) {
+	Deck deck(n);
+	deck.shuffle(rng);
+	if (i % 3 == 2) deck = firsts[rng.next(0,firsts.size()-1)];
+	if (n > 40 && i % 2 == 0) {
+	  // the same state, rotated past its leading J,Q,K and jokers
+	  Deck rotated(n);
+	  int top = Deck::forward(deck.cards,0,0);
+	  int to = rng.next(0,top);
+	  for (int j=0; j<n; ++j) rotated.cards[j]=deck.cards[(j+to) % n];
+	  if (equivalent(rotated,deck) == 0) deck = rotated;
+	}
+	bool inserted = expect.insert(deck).second;
+	ASSERT_EQ(s.insert(deck),inserted);
+	if (inserted) firsts.push_back(deck);
+	ASSERT_NE(s.find(deck),s.end());
+      }
+      ASSERT_EQ(s.size(),expect.size());
+      int i = 0;
+      for (auto deck : s) {
+	ASSERT_EQ(deck,firsts[i]);
+	ASSERT_EQ(*s.find(deck),firsts[i]);
+	++i;
+      }
+
+      // the other format re-keys the decks
+      SearchSet copy(s), merged(format == DeckCodec::RANK ? DeckCodec::PACKED : DeckCodec::RANK);
+      merged.insert(copy.begin(),copy.end());
+      merged.insert(s.begin(),s.end());
+      ASSERT_EQ(merged.size(),s.size());
+      Deck other(n);
+      ASSERT_EQ(merged.find(other) == merged.end(),expect.find(other) == expect.end());
+      std::cout << (format == DeckCodec::RANK ? "rank" : "packed") << " n=" << n << " states=" << s.size() << " bytes/state=" << s.bytesPerState()
+		<< " (std::set node >= " << sizeof(Deck)+32 << ")" << std::endl;
+    }
+  }
+}
+
 TEST(Search,Forward) {
   for (auto n : {10, 40, 41, 52, 54}) {
     for (auto len : {1,2,3}) {
@@ -69,6 +123,44 @@ TEST(Search,Forward) {
   }
 }
 
+// a search keeps the config it began with after that config is gone
+TEST(Search,Config) {
+  std::vector<Card> path = {17, 3, 29};
+  std::unique_ptr<Search> search;
+  {
+    DeckConfig top40;
+    top40.cipherZth = 5;
+    top40.cipherOffset = 35;
+    top40.cutZth = 1;
+    top40.cutOffset = 38;
+    retain<const DeckConfig> as(&top40);
+    Deck a(40),b(40);
+    for (auto card : path) b.mix(card);
+    search.reset(new Search(a,b));
+  }
+  search->maxDist = 1;
+  search->find();
+  ASSERT_FALSE(search->found());
+
+  // saved part way, it goes on under that config in a default search
+  std::string file = "/tmp/test_search_config";
+  search->save(file);
+  Deck c(40);
+  Search resumed(c,c);
+  resumed.load(file);
+  remove(file.c_str());
+  ASSERT_EQ(resumed.config.cipherOffset,35);
+  resumed.maxDist = 4;
+  resumed.find();
+  ASSERT_EQ(resumed.paths.size(),1u);
+  ASSERT_EQ(resumed.paths[0],path);
+
+  search->maxDist = 4;
+  search->find();
+  ASSERT_EQ(search->paths.size(),1u);
+  ASSERT_EQ(search->paths[0],path);
+}
+
 TEST(Search,Reverse) {
   for (auto n : {10, 40, 41, 52, 54}) {
     for (auto len : {1,2,3}) {
@@ -115,6 +207,254 @@ TEST(Search,Bidirection) {
   }
 }
 
+// levels and paths do not depend on the number of workers
+TEST(Search,Threads) {
+  for (auto n : {10, 40}) {
+    Deck a(n);
+    Deck b(n);
+    for (int i=0; i<5; ++i) {
+      b.mix(Card((7*i+3) % a.modulus()));
+    }
+    std::vector<size_t> sizes;
+    std::vector< std::vector< std::vector<Card> > > found;
+    for (auto threads : {1, 3, 8}) {
+      Search search(a,b);
+      search.threads = threads;
+      search.all = true;
+      search.maxDist = 5;
+      search.find();
+      sizes.push_back(search.forward.size()+search.fboundary.size());
+      sizes.push_back(search.reverse.size()+search.rboundary.size());
+      std::sort(search.paths.begin(),search.paths.end());
+      found.push_back(search.paths);
+    }
+    for (size_t i=2; i<sizes.size(); ++i) ASSERT_EQ(sizes[i],sizes[i-2]);
+    for (size_t i=1; i<found.size(); ++i) ASSERT_EQ(found[i],found[0]);
+    ASSERT_GT(found[0].size(),0);
+  }
+}
+
+// with all false the first meeting in boundary order is kept, so the
+// path does not depend on the workers either
+TEST(Search,ThreadsFirst) {
+  for (auto n : {10, 40}) {
+    for (int len : {4, 5}) {
+      Deck a(n);
+      Deck b(n);
+      for (int i=0; i<len; ++i) {
+	b.mix(Card((7*i+3) % a.modulus()));
+      }
+      std::vector< std::vector<Card> > found;
+      for (auto threads : {1, 2, 8}) {
+	Search search(a,b);
+	search.threads = threads;
+	search.maxDist = len;
+	search.find();
+	ASSERT_EQ(search.paths.size(),1u);
+	found.push_back(search.paths[0]);
+      }
+      for (size_t i=1; i<found.size(); ++i) ASSERT_EQ(found[i],found[0]) << "n=" << n << " len=" << len;
+    }
+  }
+}
+
+// the end the most words of len from a lead to
+Deck mostReached(const Deck &a, int len) {
+  int n = a.cards.size();
+  std::map< Deck, int, SearchSetCmp > ends;
+  for (int code=0; code < pow(n,len); ++code) {
+    Deck c(a);
+    for (int i=0, rest=code; i<len; ++i, rest /= n) c.mix(Card(rest % n));
+    ++ends[c];
+  }
+  Deck b(a);
+  int most = 0;
+  for (auto &end : ends) {
+    if (end.second > most) {
+      b = end.first;
+      most = end.second;
+    }
+  }
+  return b;
+}
+
+// every shortest word from a to b, sorted, by brute force
+std::vector< std::vector<Card> > shortestWords(const Deck &a, const Deck &b) {
+  int n = a.cards.size();
+  std::vector< std::vector<Card> > expect;
+  for (int shortest=1; expect.empty(); ++shortest) {
+    std::vector<Card> word(shortest,Card(0));
+    for (int code=0; code < pow(n,shortest); ++code) {
+      Deck c(a);
+      for (int i=0, rest=code; i<shortest; ++i, rest /= n) {
+	word[i] = Card(rest % n);
+	c.mix(word[i]);
+      }
+      if (c == b) expect.push_back(word);
+    }
+  }
+  std::sort(expect.begin(),expect.end());
+  return expect;
+}
+
+// with all, every shortest word, once
+TEST(Search,AllPaths) {
+  int n = 10;
+  for (auto len : {2, 3, 4, 5}) {
+    Deck a(n);
+    Deck b = mostReached(a,len);
+    std::vector< std::vector<Card> > expect = shortestWords(a,b);
+    Search search(a,b);
+    search.all = true;
+    search.maxDist = expect[0].size();
+    search.find();
+    std::sort(search.paths.begin(),search.paths.end());
+    ASSERT_EQ(search.paths,expect) << "len=" << len;
+  }
+}
+
+// the shortest words streamed, counted or cut short, none kept
+TEST(Search,StreamPaths) {
+  int n = 10;
+  for (auto len : {3, 5}) {
+    Deck a(n);
+    Deck b = mostReached(a,len);
+    std::vector< std::vector<Card> > expect = shortestWords(a,b);
+
+    Search listed(a,b);
+    listed.all = true;
+    listed.shortest = true;
+    listed.find();
+    std::sort(listed.paths.begin(),listed.paths.end());
+    ASSERT_EQ(listed.paths,expect) << "len=" << len;
+
+    std::vector< std::vector<Card> > streamed;
+    Search stream(a,b);
+    stream.all = true;
+    stream.shortest = true;
+    stream.onPath = [&](const std::vector<Card> &path) {
+      streamed.push_back(path);
+      return true;
+    };
+    stream.find();
+    ASSERT_TRUE(stream.paths.empty());
+    ASSERT_EQ(stream.count,expect.size());
+    ASSERT_EQ(streamed.size(),expect.size());
+    std::sort(streamed.begin(),streamed.end());
+    ASSERT_EQ(streamed,expect) << "len=" << len;
+
+    Search counted(a,b);
+    counted.all = true;
+    counted.shortest = true;
+    counted.countOnly = true;
+    counted.find();
+    ASSERT_TRUE(counted.paths.empty());
+    ASSERT_EQ(counted.count,expect.size()) << "len=" << len;
+
+    Search cut(a,b);
+    cut.all = true;
+    cut.onPath = [&](const std::vector<Card> &) { return cut.count < 2; };
+    cut.find();
+    ASSERT_TRUE(cut.done());
+    ASSERT_TRUE(cut.halted());
+    ASSERT_EQ(cut.count,2u);
+    // halted part way through a level, it cannot be saved
+    ASSERT_THROW(cut.save("/tmp/test_search_halted"),std::runtime_error);
+    // loading a saved search over it clears the halt
+    Search fresh(a,b);
+    fresh.save("/tmp/test_search_halted");
+    cut.load("/tmp/test_search_halted");
+    remove("/tmp/test_search_halted");
+    ASSERT_FALSE(cut.halted());
+  }
+}
+
+// a search saved part way goes on to the same paths
+TEST(Search,Resume) {
+  int n = 10;
+  Deck a(n);
+  Deck b(n);
+  for (int i=0; i<5; ++i) b.mix(Card((7*i+3) % n));
+  for (auto all : {false, true}) {
+    // all goes on to maxDist
+    int maxDist = all ? 5 : -1;
+    Search whole(a,b);
+    whole.all = all;
+    whole.maxDist = maxDist;
+    whole.find();
+    ASSERT_TRUE(whole.found());
+
+    std::string file = "/tmp/test_search_resume";
+    Search part(a,b);
+    part.all = all;
+    part.maxDist = 3;
+    part.find();
+    ASSERT_FALSE(part.found());
+    part.maxDist = maxDist;
+    part.save(file);
+
+    Deck c(n);
+    Search resumed(c,c);
+    resumed.load(file);
+    remove(file.c_str());
+    ASSERT_EQ(resumed.from,a);
+    ASSERT_EQ(resumed.to,b);
+    ASSERT_EQ(resumed.forward.size(),part.forward.size());
+    ASSERT_EQ(resumed.rboundary.size(),part.rboundary.size());
+    resumed.find();
+    ASSERT_EQ(resumed.dist,whole.dist);
+    ASSERT_EQ(resumed.paths,whole.paths);
+  }
+  Search missing(a,b);
+  ASSERT_THROW(missing.load("/tmp/test_search_resume_missing"),std::runtime_error);
+
+  // a file of the older spiderS1 layout is refused
+  std::string old = "/tmp/test_search_resume_old";
+  missing.save(old);
+  FILE *file = fopen(old.c_str(),"r+b");
+  ASSERT_TRUE(file != 0);
+  fseek(file,7,SEEK_SET);
+  fputc('1',file);
+  fclose(file);
+  ASSERT_THROW(missing.load(old),std::runtime_error);
+  remove(old.c_str());
+}
+
+// budgets stop find() between levels, and progress sees each level
+TEST(Search,Budget) {
+  int n = 10;
+  Deck a(n);
+  Deck b(n);
+  for (int i=0; i<5; ++i) b.mix(Card((7*i+3) % n));
+  Search search(a,b);
+  std::vector<SearchProgress> levels;
+  search.progress = [&](const SearchProgress &level) { levels.push_back(level); };
+
+  search.maxBytes = 1;
+  search.find();
+  ASSERT_TRUE(search.stopped);
+  ASSERT_EQ(search.dist,0);
+
+  search.maxBytes = 0;
+  search.maxSeconds = 1e-12;
+  search.find();
+  ASSERT_TRUE(search.stopped);
+  ASSERT_EQ(search.dist,0);
+
+  search.maxSeconds = 0;
+  search.find();
+  ASSERT_FALSE(search.stopped);
+  ASSERT_TRUE(search.found());
+  ASSERT_EQ(int(levels.size()),search.dist+1);
+  for (size_t i=0; i<levels.size(); ++i) {
+    ASSERT_EQ(levels[i].isForward,i % 2 == 0);
+    ASSERT_GT(levels[i].children,0u);
+    ASSERT_LE(levels[i].duplicates,levels[i].children);
+    ASSERT_GT(levels[i].bytes,0u);
+  }
+  ASSERT_EQ(levels[0].fboundary,size_t(n));
+}
+
 TEST(Search,Cycle) {
   for (auto n : { 10, 40}) {
     Deck a(n);
@@ -132,6 +472,137 @@ TEST(Search,Cycle) {
   }
 }
 
+// growing the cheaper side never makes more children than alternating,
+// and makes fewer once the sides are out of step
+TEST(Search,Balance) {
+  for (auto n : {10, 40}) {
+    for (auto len : {0,1,2,3,4,5}) {
+      if (n > 10 && len == 0) continue;
+      Deck a(n);
+      Deck b(n);
+      for (int i=0; i<len; ++i) b.mix(Card((33*i+17) % a.modulus()));
+      uint64_t expansions[2];
+      std::vector< std::vector<Card> > paths[2];
+      for (auto balance : {false, true}) {
+	Search search(a,b);
+	search.balance = balance;
+	search.find();
+	expansions[balance] = search.fexpansions+search.rexpansions;
+	paths[balance] = search.paths;
+      }
+      ASSERT_LE(expansions[true],expansions[false]) << "n=" << n << " len=" << len;
+      ASSERT_EQ(paths[true],paths[false]) << "n=" << n << " len=" << len;
+    }
+  }
+
+  int n = 10;
+  Deck a(n);
+  Deck b(n);
+  for (int i=0; i<6; ++i) b.mix(Card((33*i+17) % n));
+  uint64_t expansions[2];
+  for (auto balance : {false, true}) {
+    Search search(a,b);
+    search.balance = balance;
+    search.growForward();
+    search.growForward();
+    search.growForward();
+    search.find();
+    ASSERT_TRUE(search.found());
+    expansions[balance] = search.fexpansions+search.rexpansions;
+  }
+  ASSERT_LT(expansions[true],expansions[false]);
+}
+
+TEST(SearchDisk,Bidirection) {
+  for (auto n : {10, 40, 41}) {
+    for (auto len : {1,2,3,4,5}) {
+      Deck a(n);
+      Deck b(n);
+      std::vector<Card> path(len);
+      for (int i=0; i<len; ++i) {
+	path[i]=(33*i+17) % a.modulus();
+      }
+      for (int i=0; i<len; ++i) {
+	b.mix(path[i]);
+      }
+      // a budget this small spills every few thousand children
+      SearchDisk search(a,b,"/tmp",1 << 17);
+      search.maxDist = (len+1);
+      search.find();
+      ASSERT_EQ(search.paths.size(),1) << "n=" << n << " len=" << len << " path=" << path;
+      ASSERT_EQ(search.paths[0].size(),len);
+      Deck c(a);
+      for (auto card : search.paths[0]) c.mix(card);
+      ASSERT_EQ(equivalent(c,b),0) << "n=" << n << " len=" << len << " path=" << search.paths[0];
+      if (n <= 40) {
+	ASSERT_EQ(search.paths[0],path);
+      }
+    }
+  }
+}
+
+// decks bound to a config, or a config retained only while the search
+// begins, are searched under that config
+TEST(SearchDisk,Config) {
+  DeckConfig top40;
+  top40.cipherZth = 5;
+  top40.cipherOffset = 35;
+  top40.cutZth = 1;
+  top40.cutOffset = 38;
+  std::vector<Card> path = {17, 3, 29};
+  for (auto retained : {false, true}) {
+    std::unique_ptr<SearchDisk> search;
+    {
+      DeckConfig scoped = top40;
+      retain<const DeckConfig> as(retained ? &scoped : &DeckConfig::DEFAULT);
+      Deck a(40),b(40);
+      if (!retained) {
+	a.bind(&top40);
+	b.bind(&top40);
+      }
+      for (auto card : path) b.mix(card);
+      search.reset(new SearchDisk(a,b,"/tmp",1 << 17));
+    }
+    search->maxDist = 4;
+    search->find();
+    ASSERT_EQ(search->paths.size(),1u) << "retained=" << retained;
+    ASSERT_EQ(search->paths[0],path) << "retained=" << retained;
+  }
+}
+
+// the same levels and paths as Search, whatever the budget
+TEST(SearchDisk,Levels) {
+  int n = 40, len = 6;
+  Deck a(n);
+  Deck b(n);
+  for (int i=0; i<len; ++i) {
+    b.mix(Card((7*i+3) % a.modulus()));
+  }
+  Search memory(a,b);
+  memory.all = true;
+  memory.maxDist = len;
+  memory.find();
+
+  for (size_t budget : {size_t(1) << 17, size_t(1) << 24}) {
+    SearchDisk disk(a,b,"/tmp",budget);
+    disk.all = true;
+    disk.maxDist = len;
+    disk.find();
+    uint64_t forward = 0, reverse = 0;
+    for (auto states : disk.forward) forward += states;
+    for (auto states : disk.reverse) reverse += states;
+    ASSERT_EQ(forward,memory.forward.size()+memory.fboundary.size());
+    ASSERT_EQ(reverse,memory.reverse.size()+memory.rboundary.size());
+    // one path per meeting edge, where Search has every one
+    ASSERT_GT(disk.paths.size(),0);
+    ASSERT_LE(disk.paths.size(),memory.paths.size());
+    for (auto &path : disk.paths) {
+      ASSERT_NE(std::find(memory.paths.begin(),memory.paths.end(),path),memory.paths.end());
+    }
+    std::cout << "budget=" << budget << " runs=" << disk.runs << " disk bytes=" << disk.bytesOnDisk() << " paths=" << disk.paths.size() << std::endl;
+  }
+}
+
 TEST(SearchLite,Forward) {
   for (auto n : {10, 40, 41, 52, 54}) {
     for (auto len : {1,2,3}) {
@@ -209,6 +680,132 @@ TEST(SearchLite,Bidirectional) {
   }
 }
 
+// the same answers and paths as the plain recursion
+TEST(SearchLite,MeetInTheMiddle) {
+  TEST_RNG rng(20);
+  for (auto n : {10, 41}) {
+    for (int trial=0; trial<12; ++trial) {
+      Deck a(n);
+      Deck b(n);
+      if (trial % 3 == 1) a.shuffle(rng);
+      // b a few steps from a, or nowhere near it
+      b = a;
+      for (int i=0; i<trial % 4; ++i) {
+	Deck::cutBackFrontShuffle(b.cards.data(),n,rng.next(0,n-1));
+      }
+      if (trial % 3 == 2) b.shuffle(rng);
+      for (int fromDist=0; fromDist<=2; ++fromDist) {
+	for (int toDist=0; toDist<=2; ++toDist) {
+	  if (n > 40 && fromDist+toDist > 3) continue;
+	  for (auto cycle : {false, true}) {
+	    std::vector<int> expect(1,-1), result(1,-1);
+	    bool expectFound = SearchLiteDepthFirst(a,fromDist,b,toDist,expect,cycle);
+	    bool found = SearchLite(a,fromDist,b,toDist,result,cycle);
+	    ASSERT_EQ(found,expectFound) << "n=" << n << " trial=" << trial << " " << fromDist << "+" << toDist;
+	    ASSERT_EQ(result,expect) << "n=" << n << " trial=" << trial << " " << fromDist << "+" << toDist;
+	  }
+	}
+      }
+    }
+  }
+}
+
+// the same paths as SearchLite, on any number of threads
+TEST(SearchLite,Parallel) {
+  TEST_RNG rng(22);
+  for (auto n : {10, 40}) {
+    for (int trial=0; trial<6; ++trial) {
+      Deck a(n);
+      a.shuffle(rng);
+      Deck b(a);
+      for (int i=0; i<trial % 4; ++i) {
+	Deck::cutBackFrontShuffle(b.cards.data(),n,rng.next(0,n-1));
+      }
+      for (int fromDist=0; fromDist<=2; ++fromDist) {
+	for (int toDist=0; toDist<=2; ++toDist) {
+	  if (n > 10 && fromDist+toDist > 3) continue;
+	  for (auto cycle : {false, true}) {
+	    std::vector<int> expect(1,-1);
+	    bool expectFound = SearchLite(a,fromDist,b,toDist,expect,cycle);
+	    for (auto threads : {1, 4}) {
+	      std::vector<int> result(1,-1);
+	      bool found = SearchLiteParallel(a,fromDist,b,toDist,result,cycle,threads);
+	      ASSERT_EQ(found,expectFound) << "n=" << n << " trial=" << trial << " " << fromDist << "+" << toDist;
+	      ASSERT_EQ(result,expect) << "n=" << n << " trial=" << trial << " " << fromDist << "+" << toDist;
+	    }
+	  }
+	}
+      }
+    }
+  }
+}
+
+// every word of each length, in order
+void allWords(const Deck &at, int len, const Deck &to, std::vector<int> &word, std::vector< std::vector<int> > &words) {
+  if (int(word.size()) == len) {
+    if (at == to) words.push_back(word);
+    return;
+  }
+  int n = at.cards.size();
+  for (int i=0; i<n; ++i) {
+    Deck next(at);
+    Deck::cutBackFrontShuffle(next.cards.data(),n,i);
+    word.push_back(i);
+    allWords(next,len,to,word,words);
+    word.pop_back();
+  }
+}
+
+TEST(SearchLite,All) {
+  TEST_RNG rng(23);
+  int n = 10;
+  int maxDist = 4;
+  for (int trial=0; trial<6; ++trial) {
+    Deck a(n);
+    a.shuffle(rng);
+    Deck b(a);
+    for (int i=0; i<trial % 4; ++i) {
+      Deck::cutBackFrontShuffle(b.cards.data(),n,rng.next(0,n-1));
+    }
+    for (auto cycle : {false, true}) {
+      std::vector< std::vector<int> > expect;
+      int expectDist = -1;
+      for (int len = cycle ? 1 : 0; len <= maxDist && expect.empty(); ++len) {
+	std::vector<int> word;
+	allWords(a,len,b,word,expect);
+	if (!expect.empty()) expectDist = len;
+      }
+      for (auto threads : {1, 3}) {
+	std::vector< std::vector<int> > paths;
+	int dist = SearchLiteAll(a,b,maxDist,paths,cycle,threads);
+	ASSERT_EQ(dist,expectDist) << "trial=" << trial;
+	ASSERT_EQ(paths,expect) << "trial=" << trial;
+      }
+    }
+  }
+}
+
+// tables stop short of SEARCH_LITE_TABLE_BYTES
+TEST(SearchLite,TableDist) {
+  ASSERT_EQ(SearchLiteTableDist(Deck(40),2),2);
+  ASSERT_EQ(SearchLiteTableDist(Deck(40),9),4);
+  ASSERT_EQ(SearchLiteTableDist(Deck(10),9),7);
+
+  // a bigger split than fits walks the extra reverse steps forward
+  // and still finds a word, no longer than the one b was made with
+  std::vector<int> word = {0, 5, 0, 0, 7};
+  for (auto threads : {1, 3}) {
+    Deck a(40),b(40);
+    for (auto i : word) Deck::cutBackFrontShuffle(b.cards.data(),40,i);
+    std::vector<int> lite;
+    ASSERT_TRUE(SearchLiteParallel(a,0,b,6,lite,false,threads));
+    ASSERT_LE(lite.size(),word.size());
+    Deck c(a);
+    for (auto i : lite) Deck::cutBackFrontShuffle(c.cards.data(),40,i);
+    ASSERT_EQ(c,b);
+  }
+}
+
 TEST(SearchLite,Cycle) {
   for (auto n : {10, 40}) {
     Deck a(n);
@@ -2,6 +2,7 @@
 #include <math.h>
 #include "gtest/gtest.h"
 #include "solitaire.h"
+#include "histogram.h"
 
 using namespace std;
 using namespace spider;
@@ -68,26 +69,6 @@ struct Stats {
 
 };
 
-double z_luck(const std::vector<int> &counts) {
-  int n=0;
-  for (int i=0; i<counts.size(); ++i) {
-    n += counts[i];
-  }
-  double p = 1.0/double(counts.size());
-  double q = 1-p;  
-  double mu = n*p;
-  double inv_sigma = 1/sqrt(n*p);
-  double z=0.0;
-
-  for (int i=0; i<counts.size(); ++i) {
-    z += pow(inv_sigma*(counts[i]-mu),2);
-  }
-
-  z = sqrt(2.0)*(sqrt(z)-sqrt((counts.size()-1)-0.5));
-
-  return z;
-}
-
 TEST(Solitaire,Stats) {
   OS_RNG rng;
   int nt = 1000*1000;
@@ -98,57 +79,42 @@ TEST(Solitaire,Stats) {
 
   Stats padStats1,padStats2,padStats3,padStats4;
   Stats rngStats1,rngStats2,rngStats3,rngStats4;
+
+  // non-overlapping 1, 2, 3 and 4 card tuples, the 52^4 tables are
+  // reset in place rather than reallocated for every z
+  std::vector< Histogram > padCounts, rngCounts;
+  for (int dims=1; dims<=4; ++dims) {
+    padCounts.push_back(Histogram(52,dims,1,dims));
+    rngCounts.push_back(Histogram(52,dims,1,dims));
+  }
+
   for (int z=0; z<nz; ++z) {
     Solitaire solitaire;
     solitaire.shuffle(rng);
-    auto padCounts1 = std::vector< int > ( 52, 0 );
-    auto padCounts2 = std::vector< int > ( 52*52, 0);
-    auto padCounts3 = std::vector< int > ( 52*52*52, 0 );
-    auto padCounts4 = std::vector< int > ( 52*52*52*52, 0);
-
-    auto rngCounts1 = std::vector< int > ( 52, 0 );
-    auto rngCounts2 = std::vector< int > ( 52*52, 0);
-    auto rngCounts3 = std::vector< int > ( 52*52*52, 0);
-    auto rngCounts4 = std::vector< int > ( 52*52*52*52, 0);
+    for (int d=0; d<4; ++d) {
+      padCounts[d].reset();
+      rngCounts[d].reset();
+    }
 
-    int pad0=0,pad1=0,pad2=0,pad3=0,rng0=0,rng1=0,rng2=0,rng3=0;
     for (int t=0; t<nt; ++t) {
       do {
 	solitaire.next();
       } while (!solitaire.valid());
-      pad0=solitaire.pad();
-      rng0=rng.next(0,51);
-      
-      ++padCounts1[pad0];
-      ++rngCounts1[rng0];
-      if (t % 2 == 1) {
-	++padCounts2[pad1*52+pad0];
-	++rngCounts2[rng1*52+rng0];
+      int pad0=solitaire.pad();
+      int rng0=rng.next(0,51);
+      for (int d=0; d<4; ++d) {
+	padCounts[d].push(pad0);
+	rngCounts[d].push(rng0);
       }
-      if (t % 3 == 2) {
-	++padCounts3[pad2*52*52+pad1*52+pad0];
-	++rngCounts3[rng2*52*52+rng1*52+rng0];
-      }
-      if (t % 4 == 3) {
-	++padCounts4[pad3*52*52*52+pad2*52*52+pad1*52+pad0];
-	++rngCounts4[rng3*52*52*52+rng2*52*52+rng1*52+rng0];
-      }
-      pad3=pad2;
-      pad2=pad1;
-      pad1=pad0;
-
-      rng3=rng2;
-      rng2=rng1;
-      rng1=rng0;
     }
-    padStats1.add(z_luck(padCounts1));
-    padStats2.add(z_luck(padCounts2));
-    padStats3.add(z_luck(padCounts3));
-    padStats4.add(z_luck(padCounts4));
-    rngStats1.add(z_luck(rngCounts1));
-    rngStats2.add(z_luck(rngCounts2));
-    rngStats3.add(z_luck(rngCounts3));
-    rngStats4.add(z_luck(rngCounts4));
+    padStats1.add(padCounts[0].z());
+    padStats2.add(padCounts[1].z());
+    padStats3.add(padCounts[2].z());
+    padStats4.add(padCounts[3].z());
+    rngStats1.add(rngCounts[0].z());
+    rngStats2.add(rngCounts[1].z());
+    rngStats3.add(rngCounts[2].z());
+    rngStats4.add(rngCounts[3].z());
   }
 
   std::cout << "padStats1: "; padStats1.println(std::cout);
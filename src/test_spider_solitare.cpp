@@ -347,6 +347,98 @@ TEST(Spider,Ciphers) {
   }
 }
 
+TEST(Spider,Kernels) {
+  const DeckKernelTable *kernels[] = { &DECK_KERNEL_SSE4, &DECK_KERNEL_AVX2 };
+  const DeckKernelTable &scalar = DECK_KERNEL_SCALAR;
+  for (const DeckKernelTable *kernel : kernels) {
+    if (!kernel->supported()) {
+      std::cout << kernel->name << " not supported, skipped" << std::endl;
+      continue;
+    }
+    Deck deck;
+    deckInit(deck);
+    for (int trial=0; trial<CARDS; ++trial) {
+      for (Card card=0; card<CARDS; ++card) {
+	ASSERT_EQ(scalar.findCard(deck,card),kernel->findCard(deck,card)) << kernel->name << " card=" << int(card);
+      }
+      ASSERT_EQ(scalar.cipherPad(deck),kernel->cipherPad(deck)) << kernel->name;
+      for (int cutLoc=0; cutLoc<CARDS; ++cutLoc) {
+	Deck expect,result;
+	for (int i=0; i<CARDS; ++i) {
+	  expect[i]=result[i]=deck[i];
+	}
+	scalar.pseudoShuffle(expect,cutLoc);
+	kernel->pseudoShuffle(result,cutLoc);
+	DECK_EQ(expect,result);
+      }
+      // walk to a different deck for the next trial
+      scalar.pseudoShuffle(deck,(17*trial+3) % CARDS);
+    }
+  }
+}
+
+TEST(Spider,KernelDispatch) {
+  const DeckKernelTable *best = deckKernel();
+  ASSERT_TRUE(best->supported());
+  std::cout << "using " << best->name << " kernel" << std::endl;
+  ASSERT_EQ(deckUseKernel(&DECK_KERNEL_SCALAR),0);
+  ASSERT_EQ(deckKernel(),&DECK_KERNEL_SCALAR);
+  ASSERT_EQ(deckUseKernel(best),0);
+  ASSERT_EQ(deckKernel(),best);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+// cycles per call, min and max over every card / cut location; a fixed
+// time kernel should show the same spread for every input.
+TEST(Spider,KernelCycles) {
+  const DeckKernelTable *kernels[] = { &DECK_KERNEL_SCALAR, &DECK_KERNEL_SSE4, &DECK_KERNEL_AVX2 };
+  const int reps = 10000;
+  for (const DeckKernelTable *kernel : kernels) {
+    if (!kernel->supported()) continue;
+    Deck deck;
+    deckInit(deck);
+    testShuffle(deck,deck);
+    double findMin=1e9,findMax=0,shuffleMin=1e9,shuffleMax=0,padCycles;
+    volatile int sink = 0;
+    for (int x=0; x<CARDS; ++x) {
+      uint64_t t0 = __rdtsc();
+      for (int r=0; r<reps; ++r) {
+	sink += kernel->findCard(deck,x);
+      }
+      double findCycles = double(__rdtsc()-t0)/reps;
+      if (findCycles < findMin) findMin = findCycles;
+      if (findCycles > findMax) findMax = findCycles;
+
+      Deck work;
+      deckInit(work);
+      t0 = __rdtsc();
+      for (int r=0; r<reps; ++r) {
+	kernel->pseudoShuffle(work,x);
+      }
+      double shuffleCycles = double(__rdtsc()-t0)/reps;
+      if (shuffleCycles < shuffleMin) shuffleMin = shuffleCycles;
+      if (shuffleCycles > shuffleMax) shuffleMax = shuffleCycles;
+    }
+    // valid decks one shuffle apart, so the pads vary
+    Deck decks[CARDS];
+    for (int x=0; x<CARDS; ++x) {
+      for (int i=0; i<CARDS; ++i) decks[x][i] = deck[i];
+      kernel->pseudoShuffle(decks[x],x);
+    }
+    uint64_t t0 = __rdtsc();
+    for (int r=0; r<reps; ++r) {
+      sink += kernel->cipherPad(decks[r % CARDS]);
+    }
+    padCycles = double(__rdtsc()-t0)/reps;
+    std::cout << kernel->name
+	      << " find=" << findMin << ".." << findMax
+	      << " pseudoShuffle=" << shuffleMin << ".." << shuffleMax
+	      << " cipherPad=" << padCycles << " cycles" << std::endl;
+  }
+}
+#endif
 
 TEST(Spider,Encode) {
   //  for (int i=TEST_STRINGS.size()-1; i >= 0; --i) {
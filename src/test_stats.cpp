@@ -1,10 +1,13 @@
 
 #include <math.h>
+#include <sstream>
 #include "gtest/gtest.h"
 
 #include "rng.h"
 #include "card.h"
 #include "deck.h"
+#include "histogram.h"
+#include "deck_stats.h"
 
 using namespace std;
 using namespace spider;
@@ -28,313 +31,110 @@ std::ostream &operator<<(std::ostream &out, const std::vector<X> &xs)
 }
 
 
-double z_luck(const std::vector<int> &counts) {
-  int n=0;
-  for (int i=0; i<counts.size(); ++i) {
-    n += counts[i];
-  }
-  double p = 1.0/double(counts.size());
-  double q = 1-p;  
-  double mu = n*p;
-  double inv_sigma = 1/sqrt(n*p);
-  double z=0.0;
-
-  for (int i=0; i<counts.size(); ++i) {
-    z += pow(inv_sigma*(counts[i]-mu),2);
-  }
-
-  z = sqrt(2.0)*(sqrt(z)-sqrt((counts.size()-1)-0.5));
-
-  return z;
+TEST(Stats,Default) {
+  DeckStats stats;
+  stats.n = 40;
+  stats.zTrials = 100*100;
+  stats.tTrials = 1000*1000;
+  stats.cfg = DeckConfig::DEFAULT;
+  stats.progress = true;
+  stats.row();
 }
 
-double z2_luck(const std::vector< std::vector<int> > &counts) {
-  int n2=0;
-  for (int i=0; i<counts.size(); ++i) {
-    for (int j=0; j<counts[i].size(); ++j) {
-      n2 += counts[i][j];
+// the same z-trial streams give the same row, one deck at a time or
+// in a DeckBatch, on any number of threads.
+TEST(Stats,Threads) {
+  std::vector< std::string > rows;
+  for (auto batch : {false, true}) {
+    for (auto threads : {1, 2, 5}) {
+      SPLITMIX_RNG seeds(2024);
+      std::ostringstream out;
+      DeckStats stats(40,seeds,out);
+      stats.zTrials = 40;
+      stats.tTrials = 10*100;
+      stats.messageLen = 100;
+      stats.cfg = DeckConfig::DEFAULT;
+      stats.batch = batch;
+      stats.threads = threads;
+      stats.row();
+      ASSERT_LT(fabs(stats.zCipherStats.mean()),3.0);
+      ASSERT_LT(fabs(stats.zCutStats.mean()),3.0);
+      rows.push_back(out.str());
     }
   }
-  double p = 1.0/pow(double(counts.size()),2);
-  double q = 1-p;
-  double mu = n2*p;
-  double inv_sigma = 1/sqrt(n2*p);
-  double z2=0;
-
-  for (int i=0; i<counts.size(); ++i) {
-    for (int j=0; j<counts[i].size(); ++j) {    
-      z2 += pow(inv_sigma*(counts[i][j]-mu),2);
-    }
+  std::cout << rows[0];
+  for (auto row : rows) {
+    ASSERT_EQ(row,rows[0]);
   }
-
-  z2 = sqrt(2.0)*(sqrt(z2)-sqrt(pow(counts.size(),2)-1.5));
-  return z2;
-}
-
-std::vector<DeckConfig> top40Configs() {
-  std::vector<DeckConfig> cfgs;
-  { DeckConfig cfg; cfg.cipherZth = 5; cfg.cipherOffset = 35; cfg.cutZth = 1; cfg.cutOffset = 38; cfgs.push_back(cfg); }
-  return cfgs;
 }
 
-std::vector<DeckConfig> configs() {
-  std::vector<DeckConfig> cfgs;
-  DeckConfig cfg;  
-  for (auto cipherZth : {0,1,2,3,4,5}) {
-    cfg.cipherZth = cipherZth;
-    for (auto cipherOffset : {1,2,3,4,5,35,36,37,38,39}) {
-      cfg.cipherOffset=cipherOffset;
-      for (auto cutZth : {0,1,2,3,4,5}) {
-	if (cutZth == cipherZth) continue;
-	cfg.cutZth = cutZth;
-	for (auto cutOffset : {-1,1,2,3,4,5,35,36,37,38,39}) {
-	  cfg.cutOffset=cutOffset;
-	  cfgs.push_back(cfg);
-	}
+// a broken config is rejected in a few z-trials, a good one runs them
+// all and gets the same row as without early stopping
+TEST(Stats,Sprt) {
+  // the cut pad is the cipher pad: xy is all diagonal
+  DeckConfig broken = DeckConfig::DEFAULT;
+  broken.cutZth = broken.cipherZth;
+  broken.cutOffset = broken.cipherOffset;
+  for (auto cfg : {broken, DeckConfig::DEFAULT}) {
+    std::vector< std::string > rows;
+    for (auto alpha : {0.0, 1e-6}) {
+      SPLITMIX_RNG seeds(2024);
+      std::ostringstream out;
+      DeckStats stats(40,seeds,out);
+      stats.zTrials = 40;
+      stats.tTrials = 10*100;
+      stats.cfg = cfg;
+      stats.batch = true;
+      stats.threads = 2;
+      stats.sprtAlpha = alpha;
+      stats.run();
+      if (alpha > 0 && cfg.cutZth == cfg.cipherZth) {
+	ASSERT_TRUE(stats.rejects());
+	ASSERT_LE(stats.zUsed,2);
+      } else {
+	ASSERT_EQ(stats.zUsed,stats.zTrials);
       }
+      stats.outRow();
+      rows.push_back(out.str());
     }
-  }
-  return cfgs;
-}
-
-std::vector<DeckConfig> configsCutEasy() {
-  std::vector<DeckConfig> cfgs;
-  DeckConfig cfg;  
-  for (auto cipherZth : {0,1,2}) {
-    cfg.cipherZth = cipherZth;
-    for (auto cipherOffset : {1,2,3,37,38,39}) {
-      cfg.cipherOffset=cipherOffset;
-      for (auto cutZth : {0,1,2}) {
-	if (cutZth == cipherZth) continue;
-	cfg.cutZth = cutZth;
-	for (auto cutOffset : {-1}) {
-	  cfg.cutOffset=cutOffset;
-	  cfgs.push_back(cfg);
-	}
-      }
+    if (cfg.cutZth != cfg.cipherZth) {
+      ASSERT_EQ(rows[0],rows[1]);
     }
   }
-  return cfgs;
 }
 
-std::vector<DeckConfig> configsCutEasy2() {
-  std::vector<DeckConfig> cfgs;
-  DeckConfig cfg;  
-  for (auto cipherZth : {0,2}) {
-    cfg.cipherZth = cipherZth;
-    for (auto cipherOffset : {1,2,3,37,38,39}) {
-      cfg.cipherOffset=cipherOffset;
-      for (auto cutZth : {0,2}) {
-	if (cutZth == cipherZth) continue;
-	cfg.cutZth = cutZth;
-	for (auto cutOffset : {-1}) {
-	  cfg.cutOffset=cutOffset;
-	  cfgs.push_back(cfg);
+// with an rng in place of the deck the pads are uniform, and the SPRT
+// falsely rejects about sprtAlpha of the rows or fewer
+TEST(Stats,SprtUniform) {
+  const int n = 40, rows = 1000;
+  SPLITMIX_RNG rng(2024);
+  for (auto alpha : {0.05, 0.2}) {
+    std::ostringstream out;
+    DeckStats stats(n,rng,out);
+    stats.zTrials = 20;
+    stats.sprtAlpha = alpha;
+    int rejected = 0;
+    for (int row=0; row<rows; ++row) {
+      for (int z=0; z<stats.zTrials; ++z) {
+	Histogram ciphers(n), ciphers2(n,2), cuts(n), cuts2(n,2), xy(n,2);
+	for (int t=0; t<1000; ++t) {
+	  int cipher = rng.next(0,n-1), cut = rng.next(0,n-1);
+	  ciphers.add(cipher);
+	  ciphers2.push(cipher);
+	  cuts.add(cut);
+	  cuts2.push(cut);
+	  xy.add(xy.cell(cut,cipher));
 	}
-      }
-    }
-  }
-  return cfgs;
-}
-
-
-struct Stats {
-  double total;
-  double sum;
-  double sum2;
-  double min;
-  double max;
-  void reset() {
-    total = 0;
-    sum  = 0;
-    sum2 = 0;
-    min = 0;
-    max = 0;
-  }
-
-  Stats() {
-    reset();
-  }
-  
-  void add(double x, double w=1.0) {
-    if (total == 0 || x < min) {
-      min = x;
-    }
-    if (total == 0 || max < x) {
-      max = x;
-    }
-    total += w;
-    sum += w*x;
-    sum2 += w*x*x;
-  }
-
-  double mean() const  {
-    return sum / total;
-  }
-  double sd() const {
-    return sqrt(sum2/total-pow(sum/total,2));
-  }
-
-  void print(std::ostream &out) const {
-    out << "total=" << total << " mean=" << mean() << " sd=" << sd() << " min=" << min << " max=" << max;
-
-  }
-
-  void println(std::ostream &out) const {
-    print(out);
-    out << std::endl;
-  }
-};
-
-struct DeckStats {
-  int n;
-  RNG &rng;
-  std::ostream &out;
-
-  int zTrials;
-  int tTrials;
-  int messageLen;
-
-  double trials;
-  double trial;
-  int cipher0;
-  int cipher1;
-  int cut0;
-  int cut1;
-
-  int id;
-  Deck deck;
-  DeckConfig cfg;
-  
-  Stats zCipherStats;
-  Stats zCipher2Stats;      
-  Stats zCutStats;
-  Stats zCut2Stats;
-  Stats zXyStats;
-
-  bool progress;
-
-  std::vector< int > ciphers;
-  std::vector< std::vector < int > > ciphers2;
-  std::vector< int > cuts;
-  std::vector< std::vector < int > > cuts2;
-  std::vector< std::vector < int > > xy;
-
-  
-  DeckStats(int _n = 40, RNG &_rng = RNG::DEFAULT, std::ostream &_out = std::cout) : n(_n), rng(_rng), out(_out), zTrials(10*10), tTrials(100*100), messageLen(-1), trials(double(zTrials)*double(tTrials)),trial(0.0),cipher0(0), cipher1(0), cut0(0), cut1(0), id(0), deck(n), cfg(Deck::config()), ciphers(n,0), ciphers2(n,std::vector(n,0)), cuts(n,0), cuts2(n,std::vector<int>(n,0)), xy(n,std::vector<int>(n,0)), progress(false) {}
-
-  void outHeader() {
-    out << "n,cipherZth,cipherOffset,cutZth,cutOffset,cipherMean,cipherSd,cipher2Mean,cipher2Sd,cutMean,cutSd,cut2Mean,cut2Sd,xyMean,xySd" <<  std::endl;
-  }
-
-  void outRow() {
-    //    const DeckConfig &cfg = deck.config();
-    out << n << "," << cfg.cipherZth << "," << cfg.cipherOffset << "," << cfg.cutZth << "," << cfg.cutOffset << "," << zCipherStats.mean() <<  "," << zCipherStats.sd() << "," << zCipher2Stats.mean() << "," << zCipher2Stats.sd() << "," << zCutStats.mean() << "," << zCutStats.sd() << "," << zCut2Stats.mean() << "," << zCut2Stats.sd() << "," << zXyStats.mean() << "," << zXyStats.sd() << std::endl;
-  }
-
-  void tTrial(int t) {
-   
-    if (t == 0) {
-      ciphers = std::vector< int > ( n, 0 );
-      ciphers2 = std::vector< std::vector < int > > ( n, std::vector<int>(n,0) );
-      cuts = std::vector< int > ( n, 0 );
-      cuts2 = std::vector< std::vector < int > > ( n, std::vector<int>(n,0) );
-      xy = std::vector< std::vector < int > > ( n, std::vector<int>(n,0) );
-
-      deck = Deck(n);
-      deck.shuffle(rng);
-
-      cipher0=0;
-      cipher1=0;
-      cut0=0;
-      cut1=0;
-    }
-
-    if (messageLen > 0 && t % messageLen == 0) {
-      for (int i=0; i<10; ++i) {
-	deck.mix(rng.next(0,deck.modulus()-1));
-      }
-    }
-
-    static const std::string testMessage = "SPIDER SOLITAIRE ";
-    int offset = (messageLen > 0) ? (t % messageLen) : t;
-    deck.mix(rng.next(0,deck.modulus()-1));    
-    deck.mix(Card(testMessage[offset % testMessage.length()]-'A'));
-
-    cipher0=deck.cipherPad().order;
-    cut0=deck.cutPad().order;
-    ++ciphers.at(cipher0);
-    ++cuts.at(cut0);
-    ++xy.at(cut0).at(cipher0);
-    if (t > 0 || (messageLen > 0 && t % messageLen > 0)) {
-      ++ciphers2.at(cipher1).at(cipher0);
-      ++cuts2.at(cut1).at(cut0);
-    }
-    cipher1=cipher0;
-    cut1=cut0;
-    ++trial;
-  }
-
-  void zTrial(int z) {
-    for (int t=0; t<tTrials; ++t) {
-      tTrial(t);
-      if (progress) {
-	if (floor(100*trial/trials) != floor(100*(trial-1)/trials)) {
-	  out << trial << "/" << trials << "(" << floor(100*trial/trials) << "%)" << std::endl;
+	stats.zAdd(z,ZLuck{ciphers.z(),ciphers2.z(),cuts.z(),cuts2.z(),xy.z()});
+	if (stats.rejects()) {
+	  ++rejected;
+	  break;
 	}
       }
     }
-
-    if (z == 0) {
-      zCipherStats.reset();
-      zCipher2Stats.reset();
-      zCutStats.reset();
-      zCut2Stats.reset();
-      zXyStats.reset();
-    }
-    
-    zCipherStats.add(z_luck(ciphers));
-    zCipher2Stats.add(z2_luck(ciphers2));
-    zCutStats.add(z_luck(cuts));
-    zCut2Stats.add(z2_luck(cuts2));
-    zXyStats.add(z2_luck(xy));
-
-
-    if (progress) {
-      if (floor(100*double(z)/double(zTrials)) != floor(100*double(z-1)/double(zTrials))) {
-	out << "at z=" << z << " out of " << zTrials << ":" << std::endl;
-	outHeader();
-	outRow();
-      }
-    }
+    std::cout << "alpha " << alpha << " rejected " << rejected << "/" << rows << std::endl;
+    ASSERT_LE(rejected,int(1.5*alpha*rows));
   }
-
-  void row() {
-    retain<const DeckConfig> as(&cfg);
-
-    trials = double(zTrials)*double(tTrials);
-    trial = 0.0;
-    
-    for (int z=0; z<zTrials; ++z) {
-      zTrial(z);
-    }
-
-    if (id == 0) {
-      outHeader();
-    }
-    outRow();
-    ++id;
-  }
-};
-
-TEST(Stats,Default) {
-  DeckStats stats;
-  stats.n = 40;
-  stats.zTrials = 100*100;
-  stats.tTrials = 1000*1000;
-  stats.cfg = DeckConfig::DEFAULT;
-  stats.progress = true;
-  stats.row();
 }
 
 TEST(Stats,Opt) {
@@ -398,26 +198,25 @@ TEST(Deck,Luck) {
   int n = 40;
 
   Stats s1,s2,s3;
+  Histogram bins(n), bins2(n,2), bins3(n,2);
 
   for (int z=0; z<zTrials; ++z) {
+    bins.reset();
+    bins2.reset();
+    bins3.reset();
 
-    std::vector < int > bins(n,0);
-    std::vector < std::vector < int > > bins2(n, std::vector <int> (n, 0));
-    std::vector < std::vector < int > > bins3(n, std::vector <int> (n, 0));  
-
-    int a0=0,a1=rng.next(0,n-1);
+    bins3.push(rng.next(0,n-1));
     for (int t=0; t<tTrials; ++t) {
       int a0 = rng.next(0,n-1);
       int b = rng.next(0,n-1);
-      ++bins[a0];
-      ++bins2[a0][b];
-      ++bins3[a0][a1];
-      a1=a0;
+      bins.add(a0);
+      bins2.add(bins2.cell(a0,b));
+      bins3.push(a0);
     }
 
-    double z1=z_luck(bins);
-    double z2=z2_luck(bins2);
-    double z3=z2_luck(bins3);
+    double z1=bins.z();
+    double z2=bins2.z();
+    double z3=bins3.z();
 
     //  std::cout << "z_luck(rng)=" << z1 << std::endl;
     //  std::cout << "z2_luck(rng,rng)=" << z2 << std::endl;
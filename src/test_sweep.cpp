@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "gtest/gtest.h"
+
+#include "sweep.h"
+
+using namespace std;
+using namespace spider;
+
+Sweep smallSweep(const std::string &path) {
+  Sweep sweep;
+  sweep.ns = {10, 40};
+  sweep.cfgs = configsCutEasy2();
+  sweep.path = path;
+  sweep.seed = 2024;
+  sweep.zTrials = 4;
+  sweep.tTrials = 200;
+  sweep.threads = 2;
+  return sweep;
+}
+
+std::string slurp(const std::string &path) {
+  std::ifstream in(path.c_str());
+  return std::string((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+}
+
+std::vector<std::string> sortedRows(const std::string &contents) {
+  std::vector<std::string> rows;
+  std::istringstream iss(contents);
+  std::string line;
+  while (getline(iss,line)) {
+    if (line != Sweep::header() && line.compare(0,2,"# ") != 0) rows.push_back(line);
+  }
+  std::sort(rows.begin(),rows.end());
+  return rows;
+}
+
+std::string tmpPath(const std::string &name) {
+  return "tmp/test_sweep_" + name + "_" + std::to_string(getpid()) + ".csv";
+}
+
+TEST(Sweep,Shards) {
+  Sweep all = smallSweep("");
+  std::set<std::string> keys;
+  size_t count = 0;
+  for (int shard=0; shard<3; ++shard) {
+    Sweep part = all;
+    part.shard = shard;
+    part.shards = 3;
+    for (auto &item : part.items()) {
+      keys.insert(item.key());
+      ++count;
+    }
+  }
+  ASSERT_EQ(count,all.items().size());
+  ASSERT_EQ(keys.size(),all.items().size());
+}
+
+// sharded, interrupted and resumed sweeps write the same rows
+TEST(Sweep,Resume) {
+  std::string whole = tmpPath("whole");
+  Sweep sweep = smallSweep(whole);
+  remove(whole.c_str());
+  ASSERT_EQ(sweep.resume(),0);
+  std::ostringstream log;
+  ASSERT_EQ(sweep.run(log),int(sweep.items().size()));
+  std::string expect = slurp(whole);
+  remove(whole.c_str());
+
+  std::string shards;
+  for (int shard=0; shard<2; ++shard) {
+    std::string path = tmpPath("shard");
+    remove(path.c_str());
+    Sweep part = smallSweep(path);
+    part.shard = shard;
+    part.shards = 2;
+    part.threads = 1 + shard;
+    part.run(log);
+    shards += slurp(path);
+    remove(path.c_str());
+  }
+  ASSERT_EQ(sortedRows(shards),sortedRows(expect));
+
+  // crash after the settings, the header, 3 rows and part of the 4th
+  std::string crashed = tmpPath("crashed");
+  {
+    std::ofstream out(crashed.c_str());
+    size_t at = 0;
+    for (int line=0; line<5; ++line) at = expect.find('\n',at)+1;
+    out << expect.substr(0,at) << expect.substr(at,10);
+  }
+  Sweep resumed = smallSweep(crashed);
+  ASSERT_EQ(resumed.resume(),3);
+  ASSERT_EQ(resumed.run(log),int(resumed.items().size())-3);
+  ASSERT_EQ(slurp(crashed),expect);
+
+  // nothing left to do
+  ASSERT_EQ(resumed.resume(),int(resumed.items().size()));
+  ASSERT_EQ(resumed.run(log),0);
+  ASSERT_EQ(slurp(crashed),expect);
+  remove(crashed.c_str());
+}
+
+// only a torn last line is dropped; anything else stops the resume
+// and leaves the file as it was
+TEST(Sweep,Refuse) {
+  std::string whole = tmpPath("refuse");
+  Sweep sweep = smallSweep(whole);
+  remove(whole.c_str());
+  std::ostringstream log;
+  sweep.run(log);
+  std::string expect = slurp(whole);
+  size_t row2 = 0;
+  for (int line=0; line<3; ++line) row2 = expect.find('\n',row2)+1;
+
+  std::vector<std::string> bad = {
+    "n,other,columns\n" + expect.substr(expect.find('\n')+1),
+    "something else",
+    expect.substr(0,row2) + "10,0\n" + expect.substr(row2),
+  };
+  for (auto tweak : {&Sweep::zTrials, &Sweep::tTrials, &Sweep::messageLen}) {
+    Sweep other = smallSweep(whole);
+    other.*tweak += 1;
+    bad.push_back(other.settings() + expect.substr(expect.find('\n')));
+  }
+  {
+    Sweep other = smallSweep(whole);
+    other.seed += 1;
+    bad.push_back(other.settings() + expect.substr(expect.find('\n')));
+    other = smallSweep(whole);
+    other.sprtAlpha = 0.05;
+    bad.push_back(other.settings() + expect.substr(expect.find('\n')));
+  }
+
+  for (auto &contents : bad) {
+    {
+      std::ofstream out(whole.c_str(),std::ios::trunc);
+      out << contents;
+    }
+    Sweep resumed = smallSweep(whole);
+    ASSERT_THROW(resumed.resume(),std::runtime_error);
+    ASSERT_EQ(slurp(whole),contents);
+  }
+
+  // a torn settings line is rewritten whole
+  {
+    std::ofstream out(whole.c_str(),std::ios::trunc);
+    out << expect.substr(0,5);
+  }
+  Sweep resumed = smallSweep(whole);
+  ASSERT_EQ(resumed.resume(),0);
+  ASSERT_EQ(resumed.run(log),int(resumed.items().size()));
+  ASSERT_EQ(slurp(whole),expect);
+  remove(whole.c_str());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}